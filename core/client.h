@@ -9,19 +9,50 @@
 #ifndef YCSB_C_CLIENT_H_
 #define YCSB_C_CLIENT_H_
 
+#include <memory>
 #include <string>
 #include "db.h"
 #include "core_workload.h"
+#include "measurements.h"
+#include "timer.h"
 #include "utils.h"
 
 namespace ycsbc {
 
 class Client {
  public:
-  Client(DB &db, CoreWorkload &wl) : db_(db), workload_(wl) { }
+  Client(DB &db, CoreWorkload &wl) :
+      db_(db), workload_(wl), slice_db_(db.GetSliceDB()), num_batched_(0),
+      batch_intended_start_ns_(0), num_inserts_batched_(0),
+      num_file_records_(0) { }
   
   virtual bool DoInsert();
   virtual bool DoTransaction();
+  ///
+  /// Issues the operations held back for a batch, if any, and completes
+  /// the file of an ingest load. Called once after the last operation.
+  ///
+  /// @return The number of operations already counted as done that then
+  ///         failed, e.g. the records of a last insert batch that failed.
+  ///
+  virtual int Flush() {
+    int lost = 0;
+    size_t num_reads = num_batched_;
+    if (FlushReads() != DB::kOK) {
+      for (size_t i = 0; i < num_reads && i < batch_statuses_.size(); ++i)
+        lost += (batch_statuses_[i] != DB::kOK);
+    }
+    size_t num_inserts = num_inserts_batched_;
+    if (FlushInserts() != DB::kOK)
+      lost += num_inserts;
+    if (file_writer_) {
+      if (file_writer_->Finish() != DB::kOK)
+        lost += num_file_records_;
+      file_writer_.reset();
+      num_file_records_ = 0;
+    }
+    return lost;
+  }
   
   virtual ~Client() { }
   
@@ -32,13 +63,98 @@ class Client {
   virtual int TransactionScan();
   virtual int TransactionUpdate();
   virtual int TransactionInsert();
+  virtual int TransactionMultiKey();
+  ///
+  /// Issue the reads (inserts) held back for a batch, if any. Reads are
+  /// flushed before any other operation of a transaction.
+  ///
+  virtual int FlushReads();
+  virtual int FlushInserts();
+  // Issues the held reads as one MultiRead.
+  int IssueReads();
   
   DB &db_;
   CoreWorkload &workload_;
+
+  // With a SliceDB, operations reuse these buffers instead of building
+  // strings and vectors each time.
+  SliceDB *slice_db_;
+  ResultBuffer result_;
+  std::vector<Slice> fields_;
+  std::vector<SliceDB::SliceKVPair> values_;
+
+  // Consumes streamed scans by adding up what they return.
+  class ScanCounter : public ScanVisitor {
+   public:
+    ScanCounter() : records(0), bytes(0) { }
+    void Field(const Slice &field, const Slice &value) {
+      bytes += field.size() + value.size();
+    }
+    void EndRecord() { records++; }
+    uint64_t records;
+    uint64_t bytes;
+  };
+  ScanCounter scan_counter_;
+
+  // With workload_.read_batch_size() > 1, consecutive reads are held here
+  // and issued together as one MultiRead.
+  std::vector<std::string> batch_keys_;
+  size_t num_batched_;
+  // The intended start time set for the first held read, if any.
+  uint64_t batch_intended_start_ns_;
+  std::vector<Slice> batch_key_slices_;
+  std::vector<int> batch_statuses_;
+
+  // With workload_.load_batch_size() > 1, loaded records are held here and
+  // inserted together as one BatchInsert.
+  std::vector<std::string> insert_keys_;
+  std::vector<std::vector<DB::KVPair>> insert_values_;
+  size_t num_inserts_batched_;
+
+  // The records of a multi-key transaction, reused across transactions.
+  std::vector<std::string> txn_keys_;
+  std::vector<std::vector<DB::KVPair>> txn_values_;
+
+  // With workload_.ingest_load(), loaded records go to this file instead.
+  std::unique_ptr<RecordFileWriter> file_writer_;
+  // The records added to file_writer_, lost if it cannot be finished.
+  size_t num_file_records_;
 };
 
 inline bool Client::DoInsert() {
-  std::string key = workload_.NextSequenceKey();
+  const std::string &key = workload_.NextSequenceKey();
+  if (workload_.ingest_load()) {
+    if (!file_writer_)
+      file_writer_.reset(db_.GetIngestDB()->NewFileWriter(workload_.NextTable()));
+    values_.clear();
+    workload_.BuildValues(values_);
+    uint64_t ist = Measurements::get_measurements().get_intended_start_time_ns();
+    uint64_t st = utils::NowNanos();
+    int status = file_writer_->Add(key, values_);
+    uint64_t en = utils::NowNanos();
+    Measurements::get_measurements().measure(OP_INSERT, status != DB::kOK, (en - st) / 1000);
+    Measurements::get_measurements().measure_intended(OP_INSERT, status != DB::kOK, (en - ist) / 1000);
+    Measurements::get_measurements().report_status(OP_INSERT, status);
+    num_file_records_ += (status == DB::kOK);
+    return (status == DB::kOK);
+  }
+  if (workload_.load_batch_size() > 1) {
+    if (insert_keys_.size() <= num_inserts_batched_) {
+      insert_keys_.resize(num_inserts_batched_ + 1);
+      insert_values_.resize(num_inserts_batched_ + 1);
+    }
+    insert_keys_[num_inserts_batched_].assign(key);
+    insert_values_[num_inserts_batched_].clear();
+    workload_.BuildValues(insert_values_[num_inserts_batched_]);
+    if (++num_inserts_batched_ < workload_.load_batch_size())
+      return true;
+    return (FlushInserts() == DB::kOK);
+  }
+  if (slice_db_) {
+    values_.clear();
+    workload_.BuildValues(values_);
+    return (slice_db_->Insert(workload_.NextTable(), key, values_) == DB::kOK);
+  }
   std::vector<DB::KVPair> pairs;
   workload_.BuildValues(pairs);
   return (db_.Insert(workload_.NextTable(), key, pairs) == DB::kOK);
@@ -46,7 +162,11 @@ inline bool Client::DoInsert() {
 
 inline bool Client::DoTransaction() {
   int status = -1;
-  switch (workload_.NextOperation()) {
+  int flush_status = DB::kOK;
+  Operation op = workload_.NextOperation();
+  if (op != READ && num_batched_ > 0)
+    flush_status = FlushReads();
+  switch (op) {
     case READ:
       status = TransactionRead();
       break;
@@ -62,20 +182,92 @@ inline bool Client::DoTransaction() {
     case READMODIFYWRITE:
       status = TransactionReadModifyWrite();
       break;
+    case TRANSACTION:
+      status = TransactionMultiKey();
+      break;
     default:
       throw utils::Exception("Operation request is not recognized!");
   }
   assert(status >= 0);
-  return (status == DB::kOK);
+  // A read held for a batch counts as done; the batch's status is that of
+  // the operation that issues it.
+  return (status == DB::kOK || status == DB::kBatchedOK) && flush_status == DB::kOK;
+}
+
+inline int Client::FlushReads() {
+  if (num_batched_ == 0)
+    return DB::kOK;
+  // The batch is measured from the intended start of its first read, so
+  // the time the later ones were held is not omitted.
+  Measurements &measurements = Measurements::get_measurements();
+  uint64_t intended_start_ns = measurements.get_set_intended_start_time_ns();
+  measurements.set_intended_start_time_ns(batch_intended_start_ns_);
+  int status = IssueReads();
+  measurements.set_intended_start_time_ns(intended_start_ns);
+  return status;
+}
+
+inline int Client::IssueReads() {
+  const std::string &table = workload_.NextTable();
+  size_t n = num_batched_;
+  num_batched_ = 0;
+  // One field is chosen for the whole batch.
+  if (slice_db_) {
+    batch_key_slices_.assign(batch_keys_.begin(), batch_keys_.begin() + n);
+    result_.Clear();
+    if (!workload_.read_all_fields()) {
+      fields_.assign(1, workload_.NextFieldName());
+      return slice_db_->MultiRead(table, batch_key_slices_, &fields_, result_, batch_statuses_);
+    }
+    return slice_db_->MultiRead(table, batch_key_slices_, NULL, result_, batch_statuses_);
+  }
+  std::vector<std::string> keys(batch_keys_.begin(), batch_keys_.begin() + n);
+  std::vector<std::vector<DB::KVPair>> results;
+  if (!workload_.read_all_fields()) {
+    std::vector<std::string> fields;
+    fields.push_back(workload_.NextFieldName());
+    return db_.MultiRead(table, keys, &fields, results, batch_statuses_);
+  } else {
+    return db_.MultiRead(table, keys, NULL, results, batch_statuses_);
+  }
+}
+
+inline int Client::FlushInserts() {
+  if (num_inserts_batched_ == 0)
+    return DB::kOK;
+  // Only the last batch can be short.
+  insert_keys_.resize(num_inserts_batched_);
+  insert_values_.resize(num_inserts_batched_);
+  num_inserts_batched_ = 0;
+  return db_.BatchInsert(workload_.NextTable(), insert_keys_, insert_values_);
 }
 
 inline int Client::TransactionRead() {
   const std::string &table = workload_.NextTable();
   const std::string &key = workload_.NextTransactionKey();
+  if (workload_.read_batch_size() > 1) {
+    // Key strings are reused across batches to keep their capacity.
+    if (batch_keys_.size() <= num_batched_)
+      batch_keys_.resize(num_batched_ + 1);
+    if (num_batched_ == 0)
+      batch_intended_start_ns_ = Measurements::get_measurements().get_set_intended_start_time_ns();
+    batch_keys_[num_batched_++].assign(key);
+    if (num_batched_ < workload_.read_batch_size())
+      return DB::kBatchedOK;
+    return FlushReads();
+  }
+  if (slice_db_) {
+    result_.Clear();
+    if (!workload_.read_all_fields()) {
+      fields_.assign(1, workload_.NextFieldName());
+      return slice_db_->Read(table, key, &fields_, result_);
+    }
+    return slice_db_->Read(table, key, NULL, result_);
+  }
   std::vector<DB::KVPair> result;
   if (!workload_.read_all_fields()) {
     std::vector<std::string> fields;
-    fields.push_back("field" + workload_.NextFieldName());
+    fields.push_back(workload_.NextFieldName());
     return db_.Read(table, key, &fields, result);
   } else {
     return db_.Read(table, key, NULL, result);
@@ -87,31 +279,69 @@ inline int Client::TransactionReadModifyWrite() {
   const std::string &key = workload_.NextTransactionKey();
   std::vector<DB::KVPair> result;
 
-  if (!workload_.read_all_fields()) {
-    std::vector<std::string> fields;
-    fields.push_back("field" + workload_.NextFieldName());
-    db_.Read(table, key, &fields, result);
-  } else {
-    db_.Read(table, key, NULL, result);
-  }
+  // The read and the update are measured individually by the DB; the pair
+  // is measured here as a whole.
+  uint64_t ist = Measurements::get_measurements().get_intended_start_time_ns();
+  uint64_t st = utils::NowNanos();
+  int status;
+  if (slice_db_) {
+    result_.Clear();
+    if (!workload_.read_all_fields()) {
+      fields_.assign(1, workload_.NextFieldName());
+      slice_db_->Read(table, key, &fields_, result_);
+    } else {
+      slice_db_->Read(table, key, NULL, result_);
+    }
 
-  std::vector<DB::KVPair> values;
-  if (workload_.write_all_fields()) {
-    workload_.BuildValues(values);
+    values_.clear();
+    if (workload_.write_all_fields()) {
+      workload_.BuildValues(values_);
+    } else {
+      workload_.BuildUpdate(values_);
+    }
+    status = slice_db_->Update(table, key, values_);
   } else {
-    workload_.BuildUpdate(values);
+    if (!workload_.read_all_fields()) {
+      std::vector<std::string> fields;
+      fields.push_back(workload_.NextFieldName());
+      db_.Read(table, key, &fields, result);
+    } else {
+      db_.Read(table, key, NULL, result);
+    }
+
+    std::vector<DB::KVPair> values;
+    if (workload_.write_all_fields()) {
+      workload_.BuildValues(values);
+    } else {
+      workload_.BuildUpdate(values);
+    }
+    status = db_.Update(table, key, values);
   }
-  return db_.Update(table, key, values);
+  uint64_t en = utils::NowNanos();
+  Measurements::get_measurements().measure(OP_READ_MODIFY_WRITE, status != DB::kOK, (en - st) / 1000);
+  Measurements::get_measurements().measure_intended(OP_READ_MODIFY_WRITE, status != DB::kOK, (en - ist) / 1000);
+  return status;
 }
 
 inline int Client::TransactionScan() {
   const std::string &table = workload_.NextTable();
   const std::string &key = workload_.NextTransactionKey();
   int len = workload_.NextScanLength();
+  if (slice_db_) {
+    const std::vector<Slice> *fields = NULL;
+    if (!workload_.read_all_fields()) {
+      fields_.assign(1, workload_.NextFieldName());
+      fields = &fields_;
+    }
+    if (workload_.stream_scans())
+      return slice_db_->StreamScan(table, key, len, fields, scan_counter_);
+    result_.Clear();
+    return slice_db_->Scan(table, key, len, fields, result_);
+  }
   std::vector<std::vector<DB::KVPair>> result;
   if (!workload_.read_all_fields()) {
     std::vector<std::string> fields;
-    fields.push_back("field" + workload_.NextFieldName());
+    fields.push_back(workload_.NextFieldName());
     return db_.Scan(table, key, len, &fields, result);
   } else {
     return db_.Scan(table, key, len, NULL, result);
@@ -121,6 +351,15 @@ inline int Client::TransactionScan() {
 inline int Client::TransactionUpdate() {
   const std::string &table = workload_.NextTable();
   const std::string &key = workload_.NextTransactionKey();
+  if (slice_db_) {
+    values_.clear();
+    if (workload_.write_all_fields()) {
+      workload_.BuildValues(values_);
+    } else {
+      workload_.BuildUpdate(values_);
+    }
+    return slice_db_->Update(table, key, values_);
+  }
   std::vector<DB::KVPair> values;
   if (workload_.write_all_fields()) {
     workload_.BuildValues(values);
@@ -130,9 +369,31 @@ inline int Client::TransactionUpdate() {
   return db_.Update(table, key, values);
 }
 
+inline int Client::TransactionMultiKey() {
+  const std::string &table = workload_.NextTable();
+  size_t n = workload_.NextTransactionSize();
+  txn_keys_.resize(n);
+  txn_values_.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    txn_keys_[i].assign(workload_.NextTransactionKey());
+    txn_values_[i].clear();
+    if (workload_.write_all_fields()) {
+      workload_.BuildValues(txn_values_[i]);
+    } else {
+      workload_.BuildUpdate(txn_values_[i]);
+    }
+  }
+  return db_.Transaction(table, txn_keys_, txn_values_);
+}
+
 inline int Client::TransactionInsert() {
   const std::string &table = workload_.NextTable();
   const std::string &key = workload_.NextSequenceKey();
+  if (slice_db_) {
+    values_.clear();
+    workload_.BuildValues(values_);
+    return slice_db_->Insert(table, key, values_);
+  }
   std::vector<DB::KVPair> values;
   workload_.BuildValues(values);
   return db_.Insert(table, key, values);
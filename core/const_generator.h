@@ -19,6 +19,7 @@ class ConstGenerator : public Generator<uint64_t> {
   ConstGenerator(int constant) : constant_(constant) { }
   uint64_t Next() { return constant_; }
   uint64_t Last() { return constant_; }
+  ConstGenerator *Clone() const { return new ConstGenerator(*this); }
  private:
   uint64_t constant_;
 };
@@ -13,6 +13,7 @@
 #include "const_generator.h"
 #include "core_workload.h"
 
+#include <algorithm>
 #include <string>
 
 using ycsbc::CoreWorkload;
@@ -37,6 +38,21 @@ const string CoreWorkload::READ_ALL_FIELDS_DEFAULT = "true";
 const string CoreWorkload::WRITE_ALL_FIELDS_PROPERTY = "writeallfields";
 const string CoreWorkload::WRITE_ALL_FIELDS_DEFAULT = "false";
 
+const string CoreWorkload::READ_BATCH_SIZE_PROPERTY = "readbatchsize";
+const string CoreWorkload::READ_BATCH_SIZE_DEFAULT = "1";
+
+const string CoreWorkload::LOAD_BATCH_SIZE_PROPERTY = "load.batchsize";
+const string CoreWorkload::LOAD_BATCH_SIZE_DEFAULT = "1";
+
+const string CoreWorkload::LOAD_METHOD_PROPERTY = "load.method";
+const string CoreWorkload::LOAD_METHOD_DEFAULT = "insert";
+
+const string CoreWorkload::VALUE_POOL_SIZE_PROPERTY = "valuepool.size";
+const string CoreWorkload::VALUE_POOL_SIZE_DEFAULT = "1048576";
+
+const string CoreWorkload::VALUE_POOL_REFRESH_PROPERTY = "valuepool.refresh";
+const string CoreWorkload::VALUE_POOL_REFRESH_DEFAULT = "true";
+
 const string CoreWorkload::READ_PROPORTION_PROPERTY = "readproportion";
 const string CoreWorkload::READ_PROPORTION_DEFAULT = "0.95";
 
@@ -53,6 +69,16 @@ const string CoreWorkload::READMODIFYWRITE_PROPORTION_PROPERTY =
     "readmodifywriteproportion";
 const string CoreWorkload::READMODIFYWRITE_PROPORTION_DEFAULT = "0.0";
 
+const string CoreWorkload::TRANSACTION_PROPORTION_PROPERTY = "transactionproportion";
+const string CoreWorkload::TRANSACTION_PROPORTION_DEFAULT = "0.0";
+
+const string CoreWorkload::MAX_TRANSACTION_SIZE_PROPERTY = "maxtransactionsize";
+const string CoreWorkload::MAX_TRANSACTION_SIZE_DEFAULT = "4";
+
+const string CoreWorkload::TRANSACTION_SIZE_DISTRIBUTION_PROPERTY =
+    "transactionsizedistribution";
+const string CoreWorkload::TRANSACTION_SIZE_DISTRIBUTION_DEFAULT = "uniform";
+
 const string CoreWorkload::REQUEST_DISTRIBUTION_PROPERTY =
     "requestdistribution";
 const string CoreWorkload::REQUEST_DISTRIBUTION_DEFAULT = "uniform";
@@ -64,12 +90,27 @@ const string CoreWorkload::SCAN_LENGTH_DISTRIBUTION_PROPERTY =
     "scanlengthdistribution";
 const string CoreWorkload::SCAN_LENGTH_DISTRIBUTION_DEFAULT = "uniform";
 
+const string CoreWorkload::SCAN_STREAM_PROPERTY = "scanstream";
+const string CoreWorkload::SCAN_STREAM_DEFAULT = "false";
+
 const string CoreWorkload::INSERT_ORDER_PROPERTY = "insertorder";
 const string CoreWorkload::INSERT_ORDER_DEFAULT = "hashed";
 
 const string CoreWorkload::INSERT_START_PROPERTY = "insertstart";
 const string CoreWorkload::INSERT_START_DEFAULT = "0";
 
+const string CoreWorkload::SEED_PROPERTY = "seed";
+const string CoreWorkload::SEED_DEFAULT = "0";
+
+const string CoreWorkload::KEY_FORMAT_PROPERTY = "keyformat";
+const string CoreWorkload::KEY_FORMAT_DEFAULT = "decimal";
+
+const string CoreWorkload::KEY_PREFIX_PROPERTY = "keyprefix";
+const string CoreWorkload::KEY_PREFIX_DEFAULT = "user";
+
+const string CoreWorkload::KEY_LENGTH_PROPERTY = "keylength";
+const string CoreWorkload::KEY_LENGTH_DEFAULT = "0";
+
 const string CoreWorkload::RECORD_COUNT_PROPERTY = "recordcount";
 const string CoreWorkload::OPERATION_COUNT_PROPERTY = "operationcount";
 
@@ -79,6 +120,8 @@ void CoreWorkload::Init(const utils::Properties &p) {
   field_count_ = std::stoi(p.GetProperty(FIELD_COUNT_PROPERTY,
                                          FIELD_COUNT_DEFAULT));
   field_len_generator_ = GetFieldLenGenerator(p);
+  for (int i = 0; i < field_count_; ++i)
+    field_names_.push_back("field" + std::to_string(i));
   
   double read_proportion = std::stod(p.GetProperty(READ_PROPORTION_PROPERTY,
                                                    READ_PROPORTION_DEFAULT));
@@ -90,6 +133,8 @@ void CoreWorkload::Init(const utils::Properties &p) {
                                                    SCAN_PROPORTION_DEFAULT));
   double readmodifywrite_proportion = std::stod(p.GetProperty(
       READMODIFYWRITE_PROPORTION_PROPERTY, READMODIFYWRITE_PROPORTION_DEFAULT));
+  double transaction_proportion = std::stod(p.GetProperty(
+      TRANSACTION_PROPORTION_PROPERTY, TRANSACTION_PROPORTION_DEFAULT));
   
   record_count_ = std::stoi(p.GetProperty(RECORD_COUNT_PROPERTY));
   std::string request_dist = p.GetProperty(REQUEST_DISTRIBUTION_PROPERTY,
@@ -98,6 +143,10 @@ void CoreWorkload::Init(const utils::Properties &p) {
                                              MAX_SCAN_LENGTH_DEFAULT));
   std::string scan_len_dist = p.GetProperty(SCAN_LENGTH_DISTRIBUTION_PROPERTY,
                                             SCAN_LENGTH_DISTRIBUTION_DEFAULT);
+  int max_txn_size = std::stoi(p.GetProperty(MAX_TRANSACTION_SIZE_PROPERTY,
+                                             MAX_TRANSACTION_SIZE_DEFAULT));
+  std::string txn_size_dist = p.GetProperty(TRANSACTION_SIZE_DISTRIBUTION_PROPERTY,
+                                            TRANSACTION_SIZE_DISTRIBUTION_DEFAULT);
   int insert_start = std::stoi(p.GetProperty(INSERT_START_PROPERTY,
                                              INSERT_START_DEFAULT));
   
@@ -105,6 +154,20 @@ void CoreWorkload::Init(const utils::Properties &p) {
                                                     READ_ALL_FIELDS_DEFAULT));
   write_all_fields_ = utils::StrToBool(p.GetProperty(WRITE_ALL_FIELDS_PROPERTY,
                                                      WRITE_ALL_FIELDS_DEFAULT));
+  stream_scans_ = utils::StrToBool(p.GetProperty(SCAN_STREAM_PROPERTY,
+                                                 SCAN_STREAM_DEFAULT));
+  read_batch_size_ = std::max(1ul, std::stoul(p.GetProperty(READ_BATCH_SIZE_PROPERTY,
+                                                            READ_BATCH_SIZE_DEFAULT)));
+  load_batch_size_ = std::max(1ul, std::stoul(p.GetProperty(LOAD_BATCH_SIZE_PROPERTY,
+                                                            LOAD_BATCH_SIZE_DEFAULT)));
+
+  // The pool has to hold at least the longest field.
+  value_pool_size_ = std::max(
+      std::stoul(p.GetProperty(VALUE_POOL_SIZE_PROPERTY, VALUE_POOL_SIZE_DEFAULT)),
+      std::stoul(p.GetProperty(FIELD_LENGTH_PROPERTY, FIELD_LENGTH_DEFAULT)));
+  value_pool_refresh_ = utils::StrToBool(p.GetProperty(
+      VALUE_POOL_REFRESH_PROPERTY, VALUE_POOL_REFRESH_DEFAULT));
+  value_pool_.Init(value_pool_size_, value_pool_refresh_);
   
   if (p.GetProperty(INSERT_ORDER_PROPERTY, INSERT_ORDER_DEFAULT) == "hashed") {
     ordered_inserts_ = false;
@@ -112,7 +175,41 @@ void CoreWorkload::Init(const utils::Properties &p) {
     ordered_inserts_ = true;
   }
   
-  key_generator_ = new CounterGenerator(insert_start);
+  std::string key_format = p.GetProperty(KEY_FORMAT_PROPERTY, KEY_FORMAT_DEFAULT);
+  key_prefix_ = p.GetProperty(KEY_PREFIX_PROPERTY, KEY_PREFIX_DEFAULT);
+  key_length_ = std::stoul(p.GetProperty(KEY_LENGTH_PROPERTY, KEY_LENGTH_DEFAULT));
+  if (key_format == "decimal") {
+    key_format_ = KEY_DECIMAL;
+  } else if (key_format == "zeropadded") {
+    key_format_ = KEY_ZERO_PADDED;
+    if (key_length_ == 0)
+      key_length_ = key_prefix_.size() + 20;
+  } else if (key_format == "binary64") {
+    key_format_ = KEY_BINARY64;
+  } else {
+    throw utils::Exception("Unknown key format: " + key_format);
+  }
+  // Shorter keys would have different widths and no longer sort by number.
+  size_t min_key_length = key_prefix_.size() + (key_format_ == KEY_BINARY64 ? 8 : 20);
+  if (key_format_ != KEY_DECIMAL && key_length_ != 0 && key_length_ < min_key_length) {
+    throw utils::Exception("keylength must be at least " +
+                           std::to_string(min_key_length) + " for keyformat=" + key_format);
+  }
+
+  std::string load_method = p.GetProperty(LOAD_METHOD_PROPERTY, LOAD_METHOD_DEFAULT);
+  if (load_method == "ingest") {
+    // Every client file has to be sorted, and the files must not overlap.
+    if (!ordered_inserts_ || key_format_ == KEY_DECIMAL) {
+      throw utils::Exception("load.method=ingest needs insertorder=ordered "
+                             "and keyformat=zeropadded or binary64");
+    }
+    ingest_load_ = true;
+  } else if (load_method != "insert") {
+    throw utils::Exception("Unknown load method: " + load_method);
+  }
+
+  insert_start_ = insert_start;
+  key_generator_ = std::make_shared<CounterGenerator>(insert_start);
   
   if (read_proportion > 0) {
     op_chooser_.AddValue(READ, read_proportion);
@@ -129,8 +226,11 @@ void CoreWorkload::Init(const utils::Properties &p) {
   if (readmodifywrite_proportion > 0) {
     op_chooser_.AddValue(READMODIFYWRITE, readmodifywrite_proportion);
   }
+  if (transaction_proportion > 0) {
+    op_chooser_.AddValue(TRANSACTION, transaction_proportion);
+  }
   
-  insert_key_sequence_.Set(record_count_);
+  insert_key_sequence_->Set(record_count_);
   
   if (request_dist == "uniform") {
     key_chooser_ = new UniformGenerator(0, record_count_ - 1);
@@ -146,7 +246,7 @@ void CoreWorkload::Init(const utils::Properties &p) {
     key_chooser_ = new ScrambledZipfianGenerator(record_count_ + new_keys);
     
   } else if (request_dist == "latest") {
-    key_chooser_ = new SkewedLatestGenerator(insert_key_sequence_);
+    key_chooser_ = new SkewedLatestGenerator(*insert_key_sequence_);
     
   } else {
     throw utils::Exception("Unknown request distribution: " + request_dist);
@@ -162,6 +262,53 @@ void CoreWorkload::Init(const utils::Properties &p) {
     throw utils::Exception("Distribution not allowed for scan length: " +
         scan_len_dist);
   }
+
+  if (max_txn_size < 1)
+    throw utils::Exception("maxtransactionsize must be positive");
+  if (txn_size_dist == "uniform") {
+    txn_size_chooser_ = new UniformGenerator(1, max_txn_size);
+  } else if (txn_size_dist == "zipfian" && max_txn_size == 1) {
+    // A ZipfianGenerator needs a range of more than one item.
+    txn_size_chooser_ = new ConstGenerator(1);
+  } else if (txn_size_dist == "zipfian") {
+    txn_size_chooser_ = new ZipfianGenerator(1, max_txn_size);
+  } else if (txn_size_dist == "constant") {
+    txn_size_chooser_ = new ConstGenerator(max_txn_size);
+  } else {
+    throw utils::Exception("Distribution not allowed for transaction size: " +
+        txn_size_dist);
+  }
+}
+
+CoreWorkload *CoreWorkload::NewThreadWorkload() const {
+  CoreWorkload *wl = new CoreWorkload;
+  wl->table_name_ = table_name_;
+  wl->field_count_ = field_count_;
+  wl->field_names_ = field_names_;
+  wl->read_all_fields_ = read_all_fields_;
+  wl->write_all_fields_ = write_all_fields_;
+  wl->read_batch_size_ = read_batch_size_;
+  wl->load_batch_size_ = load_batch_size_;
+  wl->ingest_load_ = ingest_load_;
+  wl->stream_scans_ = stream_scans_;
+  wl->insert_start_ = insert_start_;
+  wl->value_pool_size_ = value_pool_size_;
+  wl->value_pool_refresh_ = value_pool_refresh_;
+  wl->value_pool_.Init(value_pool_size_, value_pool_refresh_);
+  wl->field_len_generator_ = field_len_generator_->Clone();
+  wl->key_generator_ = key_generator_;
+  wl->op_chooser_ = op_chooser_;
+  wl->key_chooser_ = key_chooser_->Clone();
+  wl->field_chooser_ = field_chooser_->Clone();
+  wl->scan_len_chooser_ = scan_len_chooser_->Clone();
+  wl->txn_size_chooser_ = txn_size_chooser_->Clone();
+  wl->insert_key_sequence_ = insert_key_sequence_;
+  wl->ordered_inserts_ = ordered_inserts_;
+  wl->record_count_ = record_count_;
+  wl->key_format_ = key_format_;
+  wl->key_prefix_ = key_prefix_;
+  wl->key_length_ = key_length_;
+  return wl;
 }
 
 ycsbc::Generator<uint64_t> *CoreWorkload::GetFieldLenGenerator(
@@ -183,18 +330,42 @@ ycsbc::Generator<uint64_t> *CoreWorkload::GetFieldLenGenerator(
 }
 
 void CoreWorkload::BuildValues(std::vector<ycsbc::DB::KVPair> &values) {
+  values.reserve(values.size() + field_count_);
   for (int i = 0; i < field_count_; ++i) {
-    ycsbc::DB::KVPair pair;
-    pair.first.append("field").append(std::to_string(i));
-    pair.second.append(field_len_generator_->Next(), utils::RandomPrintChar());
-    values.push_back(pair);
+    values.emplace_back();
+    ycsbc::DB::KVPair &pair = values.back();
+    pair.first.append(field_names_[i]);
+    value_pool_.Append(field_len_generator_->Next(), pair.second);
   }
 }
 
 void CoreWorkload::BuildUpdate(std::vector<ycsbc::DB::KVPair> &update) {
-  ycsbc::DB::KVPair pair;
+  update.emplace_back();
+  ycsbc::DB::KVPair &pair = update.back();
   pair.first.append(NextFieldName());
-  pair.second.append(field_len_generator_->Next(), utils::RandomPrintChar());
-  update.push_back(pair);
+  value_pool_.Append(field_len_generator_->Next(), pair.second);
+}
+
+void CoreWorkload::BuildValues(std::vector<SliceDB::SliceKVPair> &values) {
+  // Take the bytes of the whole record at once, so that refilling the pool
+  // cannot invalidate the values of earlier fields.
+  size_t first = values.size();
+  size_t total = 0;
+  for (int i = 0; i < field_count_; ++i) {
+    size_t len = field_len_generator_->Next();
+    values.emplace_back(field_names_[i], Slice(NULL, len));
+    total += len;
+  }
+  const char *bytes = value_pool_.Take(total);
+  for (size_t i = first; i < values.size(); ++i) {
+    size_t len = values[i].second.size();
+    values[i].second = Slice(bytes, len);
+    bytes += len;
+  }
 }
 
+void CoreWorkload::BuildUpdate(std::vector<SliceDB::SliceKVPair> &update) {
+  const std::string &field = NextFieldName();
+  size_t len = field_len_generator_->Next();
+  update.emplace_back(field, Slice(value_pool_.Take(len), len));
+}
@@ -9,6 +9,7 @@
 #ifndef YCSB_C_CORE_WORKLOAD_H_
 #define YCSB_C_CORE_WORKLOAD_H_
 
+#include <memory>
 #include <vector>
 #include <string>
 #include "db.h"
@@ -16,6 +17,7 @@
 #include "generator.h"
 #include "discrete_generator.h"
 #include "counter_generator.h"
+#include "value_pool.h"
 #include "utils.h"
 
 namespace ycsbc {
@@ -25,7 +27,8 @@ enum Operation {
   READ,
   UPDATE,
   SCAN,
-  READMODIFYWRITE
+  READMODIFYWRITE,
+  TRANSACTION
 };
 
 class CoreWorkload {
@@ -68,6 +71,46 @@ class CoreWorkload {
   ///
   static const std::string WRITE_ALL_FIELDS_PROPERTY;
   static const std::string WRITE_ALL_FIELDS_DEFAULT;
+
+  ///
+  /// The name of the property for the number of consecutive reads of a
+  /// client that are issued together as one DB::MultiRead. One issues each
+  /// read on its own.
+  ///
+  static const std::string READ_BATCH_SIZE_PROPERTY;
+  static const std::string READ_BATCH_SIZE_DEFAULT;
+
+  ///
+  /// The name of the property for the number of records a client inserts
+  /// together as one DB::BatchInsert while loading.
+  ///
+  static const std::string LOAD_BATCH_SIZE_PROPERTY;
+  static const std::string LOAD_BATCH_SIZE_DEFAULT;
+
+  ///
+  /// The name of the property for how the load command adds records.
+  /// Options are "insert" and "ingest", where each client writes its own
+  /// contiguous range of keys into a file that is then added to the DB
+  /// whole (see IngestDB). Ingesting needs ordered inserts and a key
+  /// format that sorts in numeric order.
+  ///
+  static const std::string LOAD_METHOD_PROPERTY;
+  static const std::string LOAD_METHOD_DEFAULT;
+
+  ///
+  /// The name of the property for the size in bytes of the per-thread pool
+  /// of random bytes that field values are cut from.
+  ///
+  static const std::string VALUE_POOL_SIZE_PROPERTY;
+  static const std::string VALUE_POOL_SIZE_DEFAULT;
+
+  ///
+  /// The name of the property for deciding whether to refill the value pool
+  /// with new random bytes each time it is used up (true), or to reuse it
+  /// (false), which makes values repeat and compress better.
+  ///
+  static const std::string VALUE_POOL_REFRESH_PROPERTY;
+  static const std::string VALUE_POOL_REFRESH_DEFAULT;
   
   /// 
   /// The name of the property for the proportion of read transactions.
@@ -99,6 +142,29 @@ class CoreWorkload {
   ///
   static const std::string READMODIFYWRITE_PROPORTION_PROPERTY;
   static const std::string READMODIFYWRITE_PROPORTION_DEFAULT;
+
+  ///
+  /// The name of the property for the proportion of multi-key transactions,
+  /// each reading and updating several records at once (see
+  /// DB::Transaction).
+  ///
+  static const std::string TRANSACTION_PROPORTION_PROPERTY;
+  static const std::string TRANSACTION_PROPORTION_DEFAULT;
+
+  ///
+  /// The name of the property for the max number of records a transaction
+  /// reads and updates.
+  ///
+  static const std::string MAX_TRANSACTION_SIZE_PROPERTY;
+  static const std::string MAX_TRANSACTION_SIZE_DEFAULT;
+
+  ///
+  /// The name of the property for the transaction size distribution.
+  /// Options are "uniform", "zipfian" (favoring small transactions) and
+  /// "constant" (always the max size).
+  ///
+  static const std::string TRANSACTION_SIZE_DISTRIBUTION_PROPERTY;
+  static const std::string TRANSACTION_SIZE_DISTRIBUTION_DEFAULT;
   
   /// 
   /// The name of the property for the the distribution of request keys.
@@ -120,6 +186,14 @@ class CoreWorkload {
   static const std::string SCAN_LENGTH_DISTRIBUTION_PROPERTY;
   static const std::string SCAN_LENGTH_DISTRIBUTION_DEFAULT;
 
+  ///
+  /// The name of the property for deciding whether scans hand their records
+  /// to the client as they are read (true) instead of collecting them
+  /// first (false). Only DBs with a SliceDB interface stream.
+  ///
+  static const std::string SCAN_STREAM_PROPERTY;
+  static const std::string SCAN_STREAM_DEFAULT;
+
   /// 
   /// The name of the property for the order to insert records.
   /// Options are "ordered" or "hashed".
@@ -129,7 +203,39 @@ class CoreWorkload {
 
   static const std::string INSERT_START_PROPERTY;
   static const std::string INSERT_START_DEFAULT;
+
+  ///
+  /// The name of the property for the format of the key number.
+  /// Options are "decimal", "zeropadded" (decimal padded with zeros to
+  /// keylength, so keys sort in numeric order) and "binary64" (8 bytes,
+  /// big-endian, padded with zero bytes to keylength).
+  ///
+  static const std::string KEY_FORMAT_PROPERTY;
+  static const std::string KEY_FORMAT_DEFAULT;
+
+  ///
+  /// The name of the property for the string every key starts with.
+  ///
+  static const std::string KEY_PREFIX_PROPERTY;
+  static const std::string KEY_PREFIX_DEFAULT;
+
+  ///
+  /// The name of the property for the length of a key, prefix included,
+  /// for the fixed-width formats. Zero is the shortest length that fits
+  /// every key: 20 digits or 8 bytes after the prefix. Shorter lengths are
+  /// rejected.
+  ///
+  static const std::string KEY_LENGTH_PROPERTY;
+  static const std::string KEY_LENGTH_DEFAULT;
   
+  ///
+  /// The name of the property for the seed of all random choices. Each
+  /// client thread derives its own stream from it, so runs with the same
+  /// seed and thread count make the same choices.
+  ///
+  static const std::string SEED_PROPERTY;
+  static const std::string SEED_DEFAULT;
+
   static const std::string RECORD_COUNT_PROPERTY;
   static const std::string OPERATION_COUNT_PROPERTY;
 
@@ -138,76 +244,152 @@ class CoreWorkload {
   /// Called once, in the main client thread, before any operations are started.
   ///
   virtual void Init(const utils::Properties &p);
+
+  ///
+  /// Creates the workload of a client thread, called once per thread after
+  /// Init(). It shares the insert key sequences with this workload but has
+  /// its own choosers, so threads pick keys, operations and fields without
+  /// contending on shared generators.
+  ///
+  virtual CoreWorkload *NewThreadWorkload() const;
+
+  ///
+  /// Gives this workload a sequence of load keys of its own, starting
+  /// offset records after insertstart, instead of the shared one.
+  ///
+  void SetSequenceKeyOffset(uint64_t offset) {
+    key_generator_ = std::make_shared<CounterGenerator>(insert_start_ + offset);
+  }
   
   virtual void BuildValues(std::vector<ycsbc::DB::KVPair> &values);
   virtual void BuildUpdate(std::vector<ycsbc::DB::KVPair> &update);
+  ///
+  /// Same as above for SliceDB. The views point into this workload and
+  /// stay valid until values are built again.
+  ///
+  virtual void BuildValues(std::vector<SliceDB::SliceKVPair> &values);
+  virtual void BuildUpdate(std::vector<SliceDB::SliceKVPair> &update);
   
-  virtual std::string NextTable() { return table_name_; }
-  virtual std::string NextSequenceKey(); /// Used for loading data
-  virtual std::string NextTransactionKey(); /// Used for transactions
+  virtual const std::string &NextTable() { return table_name_; }
+  ///
+  /// The returned key stays valid until the next key is generated by this
+  /// workload.
+  ///
+  virtual const std::string &NextSequenceKey(); /// Used for loading data
+  virtual const std::string &NextTransactionKey(); /// Used for transactions
   virtual Operation NextOperation() { return op_chooser_.Next(); }
-  virtual std::string NextFieldName();
+  virtual const std::string &NextFieldName();
   virtual size_t NextScanLength() { return scan_len_chooser_->Next(); }
+  virtual size_t NextTransactionSize() { return txn_size_chooser_->Next(); }
   
   bool read_all_fields() const { return read_all_fields_; }
   bool write_all_fields() const { return write_all_fields_; }
+  size_t read_batch_size() const { return read_batch_size_; }
+  size_t load_batch_size() const { return load_batch_size_; }
+  bool ingest_load() const { return ingest_load_; }
+  bool stream_scans() const { return stream_scans_; }
 
   CoreWorkload() :
       field_count_(0), read_all_fields_(false), write_all_fields_(false),
+      read_batch_size_(1), load_batch_size_(1), ingest_load_(false),
+      stream_scans_(false),
+      value_pool_size_(0), value_pool_refresh_(true),
       field_len_generator_(NULL), key_generator_(NULL), key_chooser_(NULL),
-      field_chooser_(NULL), scan_len_chooser_(NULL), insert_key_sequence_(3),
-      ordered_inserts_(true), record_count_(0) {
+      field_chooser_(NULL), scan_len_chooser_(NULL), txn_size_chooser_(NULL),
+      insert_key_sequence_(new CounterGenerator(3)),
+      ordered_inserts_(true), record_count_(0), insert_start_(0),
+      key_format_(KEY_DECIMAL),
+      key_prefix_("user"), key_length_(0) {
   }
   
   virtual ~CoreWorkload() {
     if (field_len_generator_) delete field_len_generator_;
-    if (key_generator_) delete key_generator_;
     if (key_chooser_) delete key_chooser_;
     if (field_chooser_) delete field_chooser_;
     if (scan_len_chooser_) delete scan_len_chooser_;
+    if (txn_size_chooser_) delete txn_size_chooser_;
   }
   
  protected:
+  enum KeyFormat {
+    KEY_DECIMAL,
+    KEY_ZERO_PADDED,
+    KEY_BINARY64
+  };
+
   static Generator<uint64_t> *GetFieldLenGenerator(const utils::Properties &p);
-  std::string BuildKeyName(uint64_t key_num);
+  const std::string &BuildKeyName(uint64_t key_num);
 
   std::string table_name_;
   int field_count_;
   bool read_all_fields_;
   bool write_all_fields_;
+  size_t read_batch_size_;
+  size_t load_batch_size_;
+  bool ingest_load_;
+  bool stream_scans_;
+  size_t value_pool_size_;
+  bool value_pool_refresh_;
+  ValuePool value_pool_;
   Generator<uint64_t> *field_len_generator_;
-  Generator<uint64_t> *key_generator_;
+  std::shared_ptr<CounterGenerator> key_generator_;
   DiscreteGenerator<Operation> op_chooser_;
   Generator<uint64_t> *key_chooser_;
   Generator<uint64_t> *field_chooser_;
   Generator<uint64_t> *scan_len_chooser_;
-  CounterGenerator insert_key_sequence_;
+  Generator<uint64_t> *txn_size_chooser_;
+  std::shared_ptr<CounterGenerator> insert_key_sequence_;
   bool ordered_inserts_;
   size_t record_count_;
+  uint64_t insert_start_;
+  KeyFormat key_format_;
+  std::string key_prefix_;
+  size_t key_length_;
+  std::string key_; /// Reused by every key this workload generates
+  std::vector<std::string> field_names_;
 };
 
-inline std::string CoreWorkload::NextSequenceKey() {
+inline const std::string &CoreWorkload::NextSequenceKey() {
   uint64_t key_num = key_generator_->Next();
   return BuildKeyName(key_num);
 }
 
-inline std::string CoreWorkload::NextTransactionKey() {
+inline const std::string &CoreWorkload::NextTransactionKey() {
   uint64_t key_num;
   do {
     key_num = key_chooser_->Next();
-  } while (key_num > insert_key_sequence_.Last());
+  } while (key_num > insert_key_sequence_->Last());
   return BuildKeyName(key_num);
 }
 
-inline std::string CoreWorkload::BuildKeyName(uint64_t key_num) {
+inline const std::string &CoreWorkload::BuildKeyName(uint64_t key_num) {
   if (!ordered_inserts_) {
     key_num = utils::Hash(key_num);
   }
-  return std::string("user").append(std::to_string(key_num));
+  key_.assign(key_prefix_);
+  if (key_format_ == KEY_BINARY64) {
+    if (key_length_ > key_.size() + 8)
+      key_.append(key_length_ - key_.size() - 8, '\0');
+    for (int shift = 56; shift >= 0; shift -= 8)
+      key_.push_back((char)(key_num >> shift));
+    return key_;
+  }
+
+  char digits[20];
+  int n = 0;
+  do {
+    digits[n++] = '0' + key_num % 10;
+    key_num /= 10;
+  } while (key_num > 0);
+  if (key_format_ == KEY_ZERO_PADDED && key_length_ > key_.size() + n)
+    key_.append(key_length_ - key_.size() - n, '0');
+  while (n > 0)
+    key_.push_back(digits[--n]);
+  return key_;
 }
 
-inline std::string CoreWorkload::NextFieldName() {
-  return std::string("field").append(std::to_string(field_chooser_->Next()));
+inline const std::string &CoreWorkload::NextFieldName() {
+  return field_names_[field_chooser_->Next()];
 }
   
 } // ycsbc
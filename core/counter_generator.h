@@ -22,6 +22,11 @@ class CounterGenerator : public Generator<uint64_t> {
   uint64_t Next() { return counter_.fetch_add(1); }
   uint64_t Last() { return counter_.load() - 1; }
   void Set(uint64_t start) { counter_.store(start); }
+  ///
+  /// The clone starts from the current count but counts on its own; to
+  /// share a sequence, share the generator instead.
+  ///
+  CounterGenerator *Clone() const { return new CounterGenerator(counter_.load()); }
  private:
   std::atomic<uint64_t> counter_;
 };
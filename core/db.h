@@ -13,9 +13,13 @@
 #include <string>
 
 #include "core/properties.h"
+#include "core/ingest_db.h"
+#include "core/slice_db.h"
 
 namespace ycsbc {
 
+class MeasurementsExporter;
+
 class DB {
  public:
   typedef std::pair<std::string, std::string> KVPair;
@@ -59,6 +63,34 @@ class DB {
                    const std::vector<std::string> *fields,
                    std::vector<KVPair> &result) = 0;
   ///
+  /// Reads a batch of records from the database.
+  /// The default implementation calls Read() for each key in turn; bindings
+  /// override it when the store can look several keys up at once.
+  ///
+  /// @param table The name of the table.
+  /// @param keys The keys of the records to read.
+  /// @param fields The list of fields to read from every record, or NULL
+  ///        for all of them.
+  /// @param results Field/value pairs of the record of each key, in order.
+  /// @param statuses The return code of the read of each key, in order.
+  /// @return Zero if every record was read, or else the first non-zero code.
+  ///
+  virtual int MultiRead(const std::string &table,
+                        const std::vector<std::string> &keys,
+                        const std::vector<std::string> *fields,
+                        std::vector<std::vector<KVPair>> &results,
+                        std::vector<int> &statuses) {
+    results.assign(keys.size(), std::vector<KVPair>());
+    statuses.resize(keys.size());
+    int res = kOK;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      statuses[i] = Read(table, keys[i], fields, results[i]);
+      if (res == kOK)
+        res = statuses[i];
+    }
+    return res;
+  }
+  ///
   /// Performs a range scan for a set of records in the database.
   /// Field/value pairs from the result are stored in a vector.
   ///
@@ -97,6 +129,54 @@ class DB {
   virtual int Insert(const std::string &table, const std::string &key,
                      std::vector<KVPair> &values) = 0;
   ///
+  /// Inserts a batch of records into the database.
+  /// The default implementation calls Insert() for each record in turn;
+  /// bindings override it to write the batch at once.
+  ///
+  /// @param table The name of the table.
+  /// @param keys The keys of the records to insert.
+  /// @param values The field/value pairs of the record of each key, in order.
+  /// @return Zero on success, or else the first non-zero code.
+  ///
+  virtual int BatchInsert(const std::string &table,
+                          const std::vector<std::string> &keys,
+                          std::vector<std::vector<KVPair>> &values) {
+    int res = kOK;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      int s = Insert(table, keys[i], values[i]);
+      if (res == kOK)
+        res = s;
+    }
+    return res;
+  }
+  ///
+  /// Reads and updates a set of records as one transaction: field/value
+  /// pairs in values[i] are written to the record of keys[i] after it is
+  /// read. The default implementation calls Read() and Update() for each
+  /// key in turn, without isolation; transactional bindings override it and
+  /// return kErrorConflict if the transaction aborted on a conflict.
+  ///
+  /// @param table The name of the table.
+  /// @param keys The keys of the records to read and update.
+  /// @param values The field/value pairs to update in the record of each
+  ///        key, in order.
+  /// @return Zero if the transaction committed, or else a non-zero code.
+  ///
+  virtual int Transaction(const std::string &table,
+                          const std::vector<std::string> &keys,
+                          std::vector<std::vector<KVPair>> &values) {
+    std::vector<KVPair> result;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      result.clear();
+      int s = Read(table, keys[i], NULL, result);
+      if (s == kOK)
+        s = Update(table, keys[i], values[i]);
+      if (s != kOK)
+        return s;
+    }
+    return kOK;
+  }
+  ///
   /// Deletes a record from the database.
   ///
   /// @param table The name of the table.
@@ -104,6 +184,36 @@ class DB {
   /// @return Zero on success, a non-zero error code on error.
   ///
   virtual int Delete(const std::string &table, const std::string &key) = 0;
+  ///
+  /// Returns the view-based interface of this DB, or NULL if the binding
+  /// only implements the string-based one above.
+  ///
+  virtual SliceDB *GetSliceDB() { return NULL; }
+  ///
+  /// Returns the file-based loading interface of this DB, or NULL if the
+  /// binding does not support it.
+  ///
+  virtual IngestDB *GetIngestDB() { return NULL; }
+  ///
+  /// Writes a copy of the database as it is now to dir, for later runs to
+  /// start from instead of loading again.
+  ///
+  /// @param dir The directory to write the copy to.
+  /// @return Zero on success, or a non-zero error code, e.g.
+  ///         kNotImplemented if the binding cannot copy its data.
+  ///
+  virtual int SaveCheckpoint(const std::string & /* dir */) { return kNotImplemented; }
+  ///
+  /// Writes statistics of the binding itself, e.g. of its storage engine,
+  /// to exporter. Called for the final report and, with periodic status,
+  /// at the end of every interval.
+  ///
+  virtual void ExportStats(MeasurementsExporter * /* exporter */) { }
+  ///
+  /// Starts the statistics of ExportStats() afresh, e.g. at the end of a
+  /// warm-up phase, the way Measurements::reset() does for latencies.
+  ///
+  virtual void ResetStats() { }
   
   virtual ~DB() { }
 };
@@ -5,12 +5,13 @@
 
 #include "core/db.h"
 #include "core/measurements.h"
+#include "core/timer.h"
 
 namespace ycsbc {
 
-class DBWrapper: public DB {
+class DBWrapper: public DB, public SliceDB {
 public:
-  DBWrapper(const std::shared_ptr<DB>& db): db_(db) {}
+  DBWrapper(const std::shared_ptr<DB>& db): db_(db), slice_db_(db->GetSliceDB()) {}
   ~DBWrapper() {
     db_.reset();
   }
@@ -20,25 +21,36 @@ public:
   void Init() { db_->Init(); }
   void Close() {
     uint64_t ist = Measurements::get_measurements().get_intended_start_time_ns();
-    uint64_t st = std::chrono::duration_cast<std::chrono::nanoseconds>(
-          std::chrono::system_clock::now().time_since_epoch()).count();
+    uint64_t st = utils::NowNanos();
     db_->Close();
-    uint64_t en = std::chrono::duration_cast<std::chrono::nanoseconds>(
-          std::chrono::system_clock::now().time_since_epoch()).count();
-    measure("CLEANUP", 0, ist, st, en);
+    uint64_t en = utils::NowNanos();
+    measure(OP_CLEANUP, 0, ist, st, en);
   }
 
   virtual int Read(const std::string &table, const std::string &key,
                    const std::vector<std::string> *fields,
                    std::vector<KVPair> &result) override {
     uint64_t ist = Measurements::get_measurements().get_intended_start_time_ns();
-    uint64_t st = std::chrono::duration_cast<std::chrono::nanoseconds>(
-          std::chrono::system_clock::now().time_since_epoch()).count();
+    uint64_t st = utils::NowNanos();
     int res = db_->Read(table, key, fields, result);
-    uint64_t en = std::chrono::duration_cast<std::chrono::nanoseconds>(
-          std::chrono::system_clock::now().time_since_epoch()).count();
-    measure("READ", res, ist, st, en);
-    Measurements::get_measurements().report_status("READ", res);
+    uint64_t en = utils::NowNanos();
+    measure(OP_READ, res, ist, st, en);
+    Measurements::get_measurements().report_status(OP_READ, res);
+    return res;
+  }
+
+  // A batch is measured as a whole as MULTI-READ (BATCH-INSERT), and each
+  // of its keys as a READ (INSERT) that took as long as the batch.
+  virtual int MultiRead(const std::string &table,
+                        const std::vector<std::string> &keys,
+                        const std::vector<std::string> *fields,
+                        std::vector<std::vector<KVPair>> &results,
+                        std::vector<int> &statuses) override {
+    uint64_t ist = Measurements::get_measurements().get_intended_start_time_ns();
+    uint64_t st = utils::NowNanos();
+    int res = db_->MultiRead(table, keys, fields, results, statuses);
+    uint64_t en = utils::NowNanos();
+    measure_batch(OP_MULTI_READ, OP_READ, res, statuses, ist, st, en);
     return res;
   }
 
@@ -46,68 +58,188 @@ public:
                    int record_count, const std::vector<std::string> *fields,
                    std::vector<std::vector<KVPair>> &result) override {
     uint64_t ist = Measurements::get_measurements().get_intended_start_time_ns();
-    uint64_t st = std::chrono::duration_cast<std::chrono::nanoseconds>(
-          std::chrono::system_clock::now().time_since_epoch()).count();
+    uint64_t st = utils::NowNanos();
     int res = db_->Scan(table, key, record_count, fields, result);
-    uint64_t en = std::chrono::duration_cast<std::chrono::nanoseconds>(
-          std::chrono::system_clock::now().time_since_epoch()).count();
-    measure("SCAN", res, ist, st, en);
-    Measurements::get_measurements().report_status("SCAN", res);
+    uint64_t en = utils::NowNanos();
+    measure(OP_SCAN, res, ist, st, en);
+    Measurements::get_measurements().report_status(OP_SCAN, res);
     return res;
   }
 
   virtual int Update(const std::string &table, const std::string &key,
                      std::vector<KVPair> &values) override {
     uint64_t ist = Measurements::get_measurements().get_intended_start_time_ns();
-    uint64_t st = std::chrono::duration_cast<std::chrono::nanoseconds>(
-          std::chrono::system_clock::now().time_since_epoch()).count();
+    uint64_t st = utils::NowNanos();
     int res = db_->Update(table, key, values);
-    uint64_t en = std::chrono::duration_cast<std::chrono::nanoseconds>(
-          std::chrono::system_clock::now().time_since_epoch()).count();
-    measure("UPDATE", res, ist, st, en);
-    Measurements::get_measurements().report_status("UPDATE", res);
+    uint64_t en = utils::NowNanos();
+    measure(OP_UPDATE, res, ist, st, en);
+    Measurements::get_measurements().report_status(OP_UPDATE, res);
     return res;
   }
 
   virtual int Insert(const std::string &table, const std::string &key,
                      std::vector<KVPair> &values) override {
     uint64_t ist = Measurements::get_measurements().get_intended_start_time_ns();
-    uint64_t st = std::chrono::duration_cast<std::chrono::nanoseconds>(
-          std::chrono::system_clock::now().time_since_epoch()).count();
+    uint64_t st = utils::NowNanos();
     int res = db_->Insert(table, key, values);
-    uint64_t en = std::chrono::duration_cast<std::chrono::nanoseconds>(
-          std::chrono::system_clock::now().time_since_epoch()).count();
-    measure("INSERT", res, ist, st, en);
-    Measurements::get_measurements().report_status("INSERT", res);
+    uint64_t en = utils::NowNanos();
+    measure(OP_INSERT, res, ist, st, en);
+    Measurements::get_measurements().report_status(OP_INSERT, res);
+    return res;
+  }
+
+  virtual int BatchInsert(const std::string &table,
+                          const std::vector<std::string> &keys,
+                          std::vector<std::vector<KVPair>> &values) override {
+    uint64_t ist = Measurements::get_measurements().get_intended_start_time_ns();
+    uint64_t st = utils::NowNanos();
+    int res = db_->BatchInsert(table, keys, values);
+    uint64_t en = utils::NowNanos();
+    measure_batch(OP_BATCH_INSERT, OP_INSERT, res, std::vector<int>(keys.size(), res), ist, st, en);
+    return res;
+  }
+
+  // A transaction is measured as a whole, from its first read to its
+  // commit, including the retries of the binding.
+  virtual int Transaction(const std::string &table,
+                          const std::vector<std::string> &keys,
+                          std::vector<std::vector<KVPair>> &values) override {
+    uint64_t ist = Measurements::get_measurements().get_intended_start_time_ns();
+    uint64_t st = utils::NowNanos();
+    int res = db_->Transaction(table, keys, values);
+    uint64_t en = utils::NowNanos();
+    measure(OP_TRANSACTION, res, ist, st, en);
+    Measurements::get_measurements().report_status(OP_TRANSACTION, res);
     return res;
   }
 
   virtual int Delete(const std::string &table, const std::string &key) override {
     uint64_t ist = Measurements::get_measurements().get_intended_start_time_ns();
-    uint64_t st = std::chrono::duration_cast<std::chrono::nanoseconds>(
-          std::chrono::system_clock::now().time_since_epoch()).count();
+    uint64_t st = utils::NowNanos();
     int res = db_->Delete(table, key);
-    uint64_t en = std::chrono::duration_cast<std::chrono::nanoseconds>(
-          std::chrono::system_clock::now().time_since_epoch()).count();
-    measure("DELETE", res, ist, st, en);
-    Measurements::get_measurements().report_status("DELETE", res);
+    uint64_t en = utils::NowNanos();
+    measure(OP_DELETE, res, ist, st, en);
+    Measurements::get_measurements().report_status(OP_DELETE, res);
+    return res;
+  }
+
+  virtual SliceDB *GetSliceDB() override { return slice_db_? this : NULL; }
+  // Records written to files are measured by Client.
+  virtual IngestDB *GetIngestDB() override { return db_->GetIngestDB(); }
+
+  // Checkpoints are measured by the caller.
+  virtual int SaveCheckpoint(const std::string &dir) override {
+    return db_->SaveCheckpoint(dir);
+  }
+
+  virtual void ExportStats(MeasurementsExporter *exporter) override {
+    db_->ExportStats(exporter);
+  }
+
+  virtual void ResetStats() override {
+    db_->ResetStats();
+  }
+
+  virtual int Read(const std::string &table, const Slice &key,
+                   const std::vector<Slice> *fields,
+                   ResultBuffer &result) override {
+    uint64_t ist = Measurements::get_measurements().get_intended_start_time_ns();
+    uint64_t st = utils::NowNanos();
+    int res = slice_db_->Read(table, key, fields, result);
+    uint64_t en = utils::NowNanos();
+    measure(OP_READ, res, ist, st, en);
+    Measurements::get_measurements().report_status(OP_READ, res);
+    return res;
+  }
+
+  virtual int MultiRead(const std::string &table, const std::vector<Slice> &keys,
+                        const std::vector<Slice> *fields, ResultBuffer &result,
+                        std::vector<int> &statuses) override {
+    uint64_t ist = Measurements::get_measurements().get_intended_start_time_ns();
+    uint64_t st = utils::NowNanos();
+    int res = slice_db_->MultiRead(table, keys, fields, result, statuses);
+    uint64_t en = utils::NowNanos();
+    measure_batch(OP_MULTI_READ, OP_READ, res, statuses, ist, st, en);
+    return res;
+  }
+
+  virtual int Scan(const std::string &table, const Slice &key,
+                   int record_count, const std::vector<Slice> *fields,
+                   ResultBuffer &result) override {
+    uint64_t ist = Measurements::get_measurements().get_intended_start_time_ns();
+    uint64_t st = utils::NowNanos();
+    int res = slice_db_->Scan(table, key, record_count, fields, result);
+    uint64_t en = utils::NowNanos();
+    measure(OP_SCAN, res, ist, st, en);
+    Measurements::get_measurements().report_status(OP_SCAN, res);
+    return res;
+  }
+
+  virtual int StreamScan(const std::string &table, const Slice &key,
+                         int record_count, const std::vector<Slice> *fields,
+                         ScanVisitor &visitor) override {
+    uint64_t ist = Measurements::get_measurements().get_intended_start_time_ns();
+    uint64_t st = utils::NowNanos();
+    int res = slice_db_->StreamScan(table, key, record_count, fields, visitor);
+    uint64_t en = utils::NowNanos();
+    measure(OP_SCAN, res, ist, st, en);
+    Measurements::get_measurements().report_status(OP_SCAN, res);
+    return res;
+  }
+
+  virtual int Update(const std::string &table, const Slice &key,
+                     const std::vector<SliceKVPair> &values) override {
+    uint64_t ist = Measurements::get_measurements().get_intended_start_time_ns();
+    uint64_t st = utils::NowNanos();
+    int res = slice_db_->Update(table, key, values);
+    uint64_t en = utils::NowNanos();
+    measure(OP_UPDATE, res, ist, st, en);
+    Measurements::get_measurements().report_status(OP_UPDATE, res);
+    return res;
+  }
+
+  virtual int Insert(const std::string &table, const Slice &key,
+                     const std::vector<SliceKVPair> &values) override {
+    uint64_t ist = Measurements::get_measurements().get_intended_start_time_ns();
+    uint64_t st = utils::NowNanos();
+    int res = slice_db_->Insert(table, key, values);
+    uint64_t en = utils::NowNanos();
+    measure(OP_INSERT, res, ist, st, en);
+    Measurements::get_measurements().report_status(OP_INSERT, res);
+    return res;
+  }
+
+  virtual int Delete(const std::string &table, const Slice &key) override {
+    uint64_t ist = Measurements::get_measurements().get_intended_start_time_ns();
+    uint64_t st = utils::NowNanos();
+    int res = slice_db_->Delete(table, key);
+    uint64_t en = utils::NowNanos();
+    measure(OP_DELETE, res, ist, st, en);
+    Measurements::get_measurements().report_status(OP_DELETE, res);
     return res;
   }
 
 private:
   std::shared_ptr<DB> db_;
+  SliceDB* slice_db_;
 
-  void measure(const std::string& op, int status, uint64_t intended_start_time_ns,
+  void measure(OperationId op, int status, uint64_t intended_start_time_ns,
         uint64_t start_time_ns, uint64_t end_time_ns) {
-    if (status != 0) {
-      Measurements::get_measurements().measure(op + "-FAILED",
-          (end_time_ns - start_time_ns) / 1000);
-      Measurements::get_measurements().measure_intended(op + "-FAILED",
-          (end_time_ns - intended_start_time_ns) / 1000);
-    }
-    else {
-      Measurements::get_measurements().measure(op, (end_time_ns - start_time_ns) / 1000);
-      Measurements::get_measurements().measure_intended(op, (end_time_ns - intended_start_time_ns) / 1000);
+    bool failed = (status != 0);
+    Measurements::get_measurements().measure(op, failed,
+        (end_time_ns - start_time_ns) / 1000);
+    Measurements::get_measurements().measure_intended(op, failed,
+        (end_time_ns - intended_start_time_ns) / 1000);
+  }
+
+  void measure_batch(OperationId batch_op, OperationId op, int status,
+        const std::vector<int>& statuses, uint64_t intended_start_time_ns,
+        uint64_t start_time_ns, uint64_t end_time_ns) {
+    measure(batch_op, status, intended_start_time_ns, start_time_ns, end_time_ns);
+    Measurements::get_measurements().report_status(batch_op, status);
+    for (int s : statuses) {
+      measure(op, s, intended_start_time_ns, start_time_ns, end_time_ns);
+      Measurements::get_measurements().report_status(op, s);
     }
   }
 };
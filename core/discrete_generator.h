@@ -11,9 +11,7 @@
 
 #include "generator.h"
 
-#include <atomic>
 #include <cassert>
-#include <mutex>
 #include <vector>
 #include "utils.h"
 
@@ -27,12 +25,14 @@ class DiscreteGenerator : public Generator<Value> {
 
   Value Next();
   Value Last() { return last_; }
+  DiscreteGenerator<Value> *Clone() const {
+    return new DiscreteGenerator<Value>(*this);
+  }
 
  private:
   std::vector<std::pair<Value, double>> values_;
   double sum_;
-  std::atomic<Value> last_;
-  std::mutex mutex_;
+  Value last_;
 };
 
 template <typename Value>
@@ -46,9 +46,7 @@ inline void DiscreteGenerator<Value>::AddValue(Value value, double weight) {
 
 template <typename Value>
 inline Value DiscreteGenerator<Value>::Next() {
-  mutex_.lock();
   double chooser = utils::RandomDouble();
-  mutex_.unlock();
   
   for (auto p = values_.cbegin(); p != values_.cend(); ++p) {
     if (chooser < p->second / sum_) {
@@ -19,6 +19,11 @@ class Generator {
  public:
   virtual Value Next() = 0;
   virtual Value Last() = 0;
+  ///
+  /// Returns a generator with the same distribution and state. Generators
+  /// are not thread-safe; each client thread works on its own clone.
+  ///
+  virtual Generator<Value> *Clone() const = 0;
   virtual ~Generator() { }
 };
 
@@ -0,0 +1,59 @@
+//
+//  ingest_db.h
+//  YCSB-C
+//
+
+#ifndef YCSB_C_INGEST_DB_H_
+#define YCSB_C_INGEST_DB_H_
+
+#include <string>
+#include <vector>
+
+#include "core/slice_db.h"
+
+namespace ycsbc {
+
+///
+/// Writes the records of one client into a file of the DB's own format.
+/// Used by a single thread.
+///
+class RecordFileWriter {
+ public:
+  ///
+  /// Adds a record to the file; keys have to be added in increasing order.
+  ///
+  virtual int Add(const Slice &key,
+                  const std::vector<SliceDB::SliceKVPair> &values) = 0;
+  ///
+  /// Completes the file, so the next IngestFiles() picks it up.
+  ///
+  virtual int Finish() = 0;
+
+  virtual ~RecordFileWriter() { }
+};
+
+///
+/// An optional interface of a DB binding that loads data by building files
+/// outside of the DB and then adding them whole, which skips the write path
+/// and the compactions that inserts would cause. A binding offers it
+/// through DB::GetIngestDB(); the return codes are those of DB.
+///
+class IngestDB {
+ public:
+  ///
+  /// Returns a writer for a new file of records of table. The caller owns
+  /// it; writers can be used from different threads concurrently.
+  ///
+  virtual RecordFileWriter *NewFileWriter(const std::string &table) = 0;
+  ///
+  /// Adds the finished files of table to the DB. Called once all writers
+  /// are done; their key ranges should not overlap.
+  ///
+  virtual int IngestFiles(const std::string &table) = 0;
+
+  virtual ~IngestDB() { }
+};
+
+} // ycsbc
+
+#endif // YCSB_C_INGEST_DB_H_
@@ -15,115 +15,161 @@ OneMeasurementRaw::OneMeasurementRaw(const std::string& name, const utils::Prope
 }
 
 void OneMeasurementRaw::measure(int latency) {
-  total_latency += latency;
-  window_total_latency_ += latency;
-  window_operations_++;
-
-  measurements_.emplace_back(latency);
+  Shard* shard = shards_.local([]() { return new Shard(); });
+  shard->measurements_.emplace_back(latency);
+  add_relaxed(shard->operations_, (uint64_t)(1));
+  add_relaxed(shard->total_latency_, (uint64_t)(latency));
 }
 
 void OneMeasurementRaw::export_measurements(MeasurementsExporter* exporter) {
+  std::vector<RawDataPoint> measurements;
+  uint64_t total_latency = 0;
+  shards_.for_each([&](Shard* shard) {
+    measurements.insert(measurements.end(), shard->measurements_.begin(), shard->measurements_.end());
+    total_latency += shard->total_latency_.load(std::memory_order_relaxed);
+  });
+
   if (f_.is_open()) {
     f_ << get_name() << " latency raw data: op, timestamp(ms), latency(us)" << std::endl;
-    for (auto& point : measurements_)
+    for (auto& point : measurements)
       f_ << get_name() << "," << point.timestamp() << "," << point.value() << std::endl;
     f_.close();
   }
   else {
     std::cout << get_name() << " latency raw data: op, timestamp(ms), latency(us)" << std::endl;
-    for (auto& point : measurements_)
+    for (auto& point : measurements)
       std::cout << get_name() << "," << point.timestamp() << "," << point.value() << std::endl;
   }
 
-  int total_ops = measurements_.size();
+  int total_ops = measurements.size();
   exporter->write(get_name(), "Total Opeartions", total_ops);
   if (total_ops > 0 && !no_summary_stats_) {
     exporter->write(get_name(), "Below is a summary of latency in microseconds:", -1);
     exporter->write(get_name(), "Average", (double)(total_latency) / (double)(total_ops));
 
-    std::sort(measurements_.begin(), measurements_.end(),
+    std::sort(measurements.begin(), measurements.end(),
         [](const RawDataPoint& l, const RawDataPoint& r) -> bool {
           return l.value_ < r.value_;
         });
 
-    exporter->write(get_name(), "Min", measurements_.front().value());
-    exporter->write(get_name(), "Max", measurements_.back().value());
-    exporter->write(get_name(), "p1", measurements_[(int)((double)(total_ops) * 0.01)].value());
-    exporter->write(get_name(), "p5", measurements_[(int)((double)(total_ops) * 0.05)].value());
-    exporter->write(get_name(), "p50", measurements_[(int)((double)(total_ops) * 0.5)].value());
-    exporter->write(get_name(), "p90", measurements_[(int)((double)(total_ops) * 0.9)].value());
-    exporter->write(get_name(), "p95", measurements_[(int)((double)(total_ops) * 0.95)].value());
-    exporter->write(get_name(), "p99", measurements_[(int)((double)(total_ops) * 0.99)].value());
-    exporter->write(get_name(), "p99.9", measurements_[(int)((double)(total_ops) * 0.999)].value());
-    exporter->write(get_name(), "p99.99", measurements_[(int)((double)(total_ops) * 0.9999)].value());
+    exporter->write(get_name(), "Min", measurements.front().value());
+    exporter->write(get_name(), "Max", measurements.back().value());
+    exporter->write(get_name(), "p1", measurements[(int)((double)(total_ops) * 0.01)].value());
+    exporter->write(get_name(), "p5", measurements[(int)((double)(total_ops) * 0.05)].value());
+    exporter->write(get_name(), "p50", measurements[(int)((double)(total_ops) * 0.5)].value());
+    exporter->write(get_name(), "p90", measurements[(int)((double)(total_ops) * 0.9)].value());
+    exporter->write(get_name(), "p95", measurements[(int)((double)(total_ops) * 0.95)].value());
+    exporter->write(get_name(), "p99", measurements[(int)((double)(total_ops) * 0.99)].value());
+    exporter->write(get_name(), "p99.9", measurements[(int)((double)(total_ops) * 0.999)].value());
+    exporter->write(get_name(), "p99.99", measurements[(int)((double)(total_ops) * 0.9999)].value());
   }
 
   export_status_counts(exporter);
 }
 
+MeasurementWindow OneMeasurementRaw::get_window() {
+  uint64_t operations = 0;
+  uint64_t total_latency = 0;
+  shards_.for_each([&](Shard* shard) {
+    operations += shard->operations_.load(std::memory_order_relaxed);
+    total_latency += shard->total_latency_.load(std::memory_order_relaxed);
+  });
+
+  MeasurementWindow window;
+  window.name = get_name();
+  std::lock_guard<std::mutex> lock(window_mutex_);
+  window.operations = operations - window_base_operations_;
+  if (window.operations > 0)
+    window.average = (double)(total_latency - window_base_latency_) / (double)(window.operations);
+  window_base_operations_ = operations;
+  window_base_latency_ = total_latency;
+  return window;
+}
+
 std::string OneMeasurementRaw::get_summary() {
-  if (window_operations_ == 0)
+  uint64_t operations = 0;
+  uint64_t total_latency = 0;
+  shards_.for_each([&](Shard* shard) {
+    operations += shard->operations_.load(std::memory_order_relaxed);
+    total_latency += shard->total_latency_.load(std::memory_order_relaxed);
+  });
+  if (operations == 0)
     return "";
 
   char buf[100];
-  sprintf(buf, "%s count: %d, average latency(us): %.2f",
-      get_name().c_str(),
-      window_operations_,
-      (double)(window_total_latency_) / (double)(window_operations_));
-  window_operations_ = 0;
-  window_total_latency_ = 0;
+  snprintf(buf, sizeof(buf), "%s count: %lu, average latency(us): %.2f",
+      get_name().c_str(), operations, (double)total_latency / (double)operations);
   std::string s = buf;
   return s;
 }
 
 OneMeasurementHistogram::OneMeasurementHistogram(const std::string& name, const utils::Properties& props):
-    OneMeasurement(name), histogram_overflow_(0), operations_(0),
-    total_latency_(0), total_squared_latency_(0),
-    window_operations_(0), window_total_latency_(0),
-    min_(-1), max_(-1) {
+    OneMeasurement(name), window_base_operations_(0), window_base_latency_(0) {
   buckets_ = stoi(props.GetProperty(BUCKETS, BUCKETS_DEFAULT));
   verbose_ = false;
   if (props.GetProperty(VERBOSE_PROPERTY, "false") == "true")
     verbose_ = true;
-  histogram_ = std::vector<uint64_t>(buckets_);
 }
 
 void OneMeasurementHistogram::measure(int latency) {
+  Shard* shard = shards_.local([this]() { return new Shard(buckets_); });
   if (latency / 1000 >= buckets_)
-    histogram_overflow_++;
+    add_relaxed(shard->histogram_overflow_, (uint64_t)(1));
   else
-    histogram_[latency / 1000]++;
-  operations_++;
-  total_latency_ += latency;
-  total_squared_latency_ += (double)(latency) * (double)(latency);
-  window_operations_++;
-  window_total_latency_ += latency;
-
-  if (min_ < 0 || latency < min_)
-    min_ = latency;
-  if (max_ < 0 || latency > max_)
-    max_ = latency;
+    add_relaxed(shard->histogram_[latency / 1000], (uint64_t)(1));
+  add_relaxed(shard->operations_, (uint64_t)(1));
+  add_relaxed(shard->total_latency_, (uint64_t)(latency));
+  add_relaxed(shard->total_squared_latency_, (double)(latency) * (double)(latency));
+
+  int min = shard->min_.load(std::memory_order_relaxed);
+  if (min < 0 || latency < min)
+    shard->min_.store(latency, std::memory_order_relaxed);
+  int max = shard->max_.load(std::memory_order_relaxed);
+  if (max < 0 || latency > max)
+    shard->max_.store(latency, std::memory_order_relaxed);
 }
 
 void OneMeasurementHistogram::export_measurements(MeasurementsExporter* exporter) {
-  double mean = total_latency_ / ((double)(operations_));
-  double variance = total_squared_latency_ / ((double)(operations_)) - (mean * mean);
-
-  exporter->write(get_name(), "Operations", operations_);
+  std::vector<uint64_t> histogram(buckets_);
+  uint64_t histogram_overflow = 0;
+  uint64_t operations = 0;
+  uint64_t total_latency = 0;
+  double total_squared_latency = 0;
+  int min = -1;
+  int max = -1;
+  shards_.for_each([&](Shard* shard) {
+    for (int i = 0; i < buckets_; i++)
+      histogram[i] += shard->histogram_[i].load(std::memory_order_relaxed);
+    histogram_overflow += shard->histogram_overflow_.load(std::memory_order_relaxed);
+    operations += shard->operations_.load(std::memory_order_relaxed);
+    total_latency += shard->total_latency_.load(std::memory_order_relaxed);
+    total_squared_latency += shard->total_squared_latency_.load(std::memory_order_relaxed);
+    int shard_min = shard->min_.load(std::memory_order_relaxed);
+    if (shard_min >= 0 && (min < 0 || shard_min < min))
+      min = shard_min;
+    int shard_max = shard->max_.load(std::memory_order_relaxed);
+    if (shard_max >= 0 && (max < 0 || shard_max > max))
+      max = shard_max;
+  });
+
+  double mean = total_latency / ((double)(operations));
+  double variance = total_squared_latency / ((double)(operations)) - (mean * mean);
+
+  exporter->write(get_name(), "Operations", operations);
   exporter->write(get_name(), "AverageLatency(us)", mean);
   exporter->write(get_name(), "LatencyVariance(us)", variance);
-  exporter->write(get_name(), "MinLatency(us)", min_);
-  exporter->write(get_name(), "MaxLatency(us)", max_);
+  exporter->write(get_name(), "MinLatency(us)", min);
+  exporter->write(get_name(), "MaxLatency(us)", max);
 
   uint64_t opcounter = 0;
   bool done_95th = false;
   for (int i = 0; i < buckets_; i++) {
-    opcounter += histogram_[i];
-    if (!done_95th && (double)(opcounter) / (double)(operations_) >= 0.95) {
+    opcounter += histogram[i];
+    if (!done_95th && (double)(opcounter) / (double)(operations) >= 0.95) {
       exporter->write(get_name(), "95thPercentileLatency(us)", i * 1000);
       done_95th = true;
     }
-    if ((double)(opcounter) / (double)(operations_) >= 0.99) {
+    if ((double)(opcounter) / (double)(operations) >= 0.99) {
       exporter->write(get_name(), "99thPercentileLatency(us)", i * 1000);
       break;
     }
@@ -133,29 +179,50 @@ void OneMeasurementHistogram::export_measurements(MeasurementsExporter* exporter
 
   if (verbose_) {
     for (int i = 0; i < buckets_; i++)
-      exporter->write(get_name(), std::to_string(i), histogram_[i]);
+      exporter->write(get_name(), std::to_string(i), histogram[i]);
 
-    exporter->write(get_name(), ">" + std::to_string(buckets_), histogram_overflow_);
+    exporter->write(get_name(), ">" + std::to_string(buckets_), histogram_overflow);
   }
 }
 
+MeasurementWindow OneMeasurementHistogram::get_window() {
+  uint64_t operations = 0;
+  uint64_t total_latency = 0;
+  shards_.for_each([&](Shard* shard) {
+    operations += shard->operations_.load(std::memory_order_relaxed);
+    total_latency += shard->total_latency_.load(std::memory_order_relaxed);
+  });
+
+  MeasurementWindow window;
+  window.name = get_name();
+  std::lock_guard<std::mutex> lock(window_mutex_);
+  window.operations = operations - window_base_operations_;
+  if (window.operations > 0)
+    window.average = (double)(total_latency - window_base_latency_) / (double)(window.operations);
+  window_base_operations_ = operations;
+  window_base_latency_ = total_latency;
+  return window;
+}
+
 std::string OneMeasurementHistogram::get_summary() {
-  if (window_operations_ == 0)
+  uint64_t operations = 0;
+  uint64_t total_latency = 0;
+  shards_.for_each([&](Shard* shard) {
+    operations += shard->operations_.load(std::memory_order_relaxed);
+    total_latency += shard->total_latency_.load(std::memory_order_relaxed);
+  });
+  if (operations == 0)
     return "";
 
   char buf[100];
-  sprintf(buf, "%s count: %lu, average latency(us): %.2f",
-      get_name().c_str(),
-      window_operations_,
-      (double)(window_total_latency_) / (double)(window_operations_));
-  window_operations_ = 0;
-  window_total_latency_ = 0;
+  snprintf(buf, sizeof(buf), "%s count: %lu, average latency(us): %.2f",
+      get_name().c_str(), operations, (double)total_latency / (double)operations);
   std::string s = buf;
   return s;
 }
 
 OneMeasurementHdrHistogram::OneMeasurementHdrHistogram(const std::string& name, const utils::Properties& props):
-    OneMeasurement(name), log_(nullptr), total_histogram_(nullptr) {
+    OneMeasurement(name), log_(nullptr), interval_histogram_(nullptr), total_histogram_(nullptr) {
   percentiles_ = get_percentile_values(props.GetProperty(PERCENTILES_PROPERTY, PERCENTILES_PROPERTY_DEFAULT));
   verbose_ = false;
   if (props.GetProperty(VERBOSE_PROPERTY, "false") == "true")
@@ -174,25 +241,33 @@ OneMeasurementHdrHistogram::OneMeasurementHdrHistogram(const std::string& name,
     base_time_.tv_sec = tp.tv_sec;
     base_time_.tv_nsec = tp.tv_usec;
     hdr_log_write_header(&histogram_log_writer_, log_, header.c_str(), &base_time_);
-
-    hdr_interval_recorder_init_all(&histogram_, 1, 1000000, 3);
   }
 }
 
 OneMeasurementHdrHistogram::~OneMeasurementHdrHistogram() {
   if (log_)
     fclose(log_);
-  if (&histogram_)
-    hdr_interval_recorder_destroy(&histogram_);
+  if (interval_histogram_)
+    hdr_close(interval_histogram_);
   if (total_histogram_)
     hdr_close(total_histogram_);
 }
 
+void OneMeasurementHdrHistogram::retire() {
+  std::lock_guard<std::mutex> lock(reader_mutex_);
+  if (log_) {
+    fclose(log_);
+    log_ = nullptr;
+  }
+}
+
 void OneMeasurementHdrHistogram::measure(int latency) {
-  hdr_interval_recorder_record_value_atomic(&histogram_, latency);
+  Shard* shard = shards_.local([]() { return new Shard(); });
+  hdr_interval_recorder_record_value(&shard->histogram_, latency);
 }
 
 void OneMeasurementHdrHistogram::export_measurements(MeasurementsExporter* exporter) {
+  std::lock_guard<std::mutex> lock(reader_mutex_);
   struct hdr_histogram* interval_histogram = get_interval_histogram_and_accumulate();
   if (log_) {
     struct timeval tp;
@@ -224,7 +299,8 @@ void OneMeasurementHdrHistogram::export_measurements(MeasurementsExporter* expor
   }
 }
 
-std::string OneMeasurementHdrHistogram::get_summary() {
+MeasurementWindow OneMeasurementHdrHistogram::get_window() {
+  std::lock_guard<std::mutex> lock(reader_mutex_);
   struct hdr_histogram* interval_histogram = get_interval_histogram_and_accumulate();
   if (log_) {
     struct timeval tp;
@@ -235,16 +311,33 @@ std::string OneMeasurementHdrHistogram::get_summary() {
     // TODO(alec), start time and end time.
     hdr_log_write(&histogram_log_writer_, log_, &base_time_, &now, interval_histogram);
   }
+  return get_window(interval_histogram);
+}
+
+MeasurementWindow OneMeasurementHdrHistogram::get_window(struct hdr_histogram* histogram) {
+  MeasurementWindow window;
+  window.name = get_name();
+  window.operations = histogram->total_count;
+  window.average = hdr_mean(histogram);
+  window.min = hdr_min(histogram);
+  window.max = hdr_max(histogram);
+  window.p50 = hdr_value_at_percentile(histogram, 50);
+  window.p90 = hdr_value_at_percentile(histogram, 90);
+  window.p99 = hdr_value_at_percentile(histogram, 99);
+  window.p999 = hdr_value_at_percentile(histogram, 99.9);
+  window.p9999 = hdr_value_at_percentile(histogram, 99.99);
+  if (window.operations == 0) {
+    window.average = 0;
+    window.min = window.max = 0;
+  }
+  return window;
+}
 
-  std::stringstream ss(std::stringstream::in | std::stringstream::out);
-  ss << std::setprecision(2) << "[" << get_name() << ": Count=" << interval_histogram->total_count
-     << ", Max=" << hdr_max(interval_histogram) << ", Min=" << hdr_min(interval_histogram)
-     << ", Avg=" << hdr_mean(interval_histogram)
-     << ", 90=" << hdr_value_at_percentile(interval_histogram, 90)
-     << ", 99=" << hdr_value_at_percentile(interval_histogram, 99)
-     << ", 99.9=" << hdr_value_at_percentile(interval_histogram, 99.9)
-     << ", 99.99=" << hdr_value_at_percentile(interval_histogram, 99.99) << "]";
-  return ss.str();
+std::string OneMeasurementHdrHistogram::get_summary() {
+  // Ends the interval not yet reported, which adds it to total_histogram_.
+  get_window();
+  std::lock_guard<std::mutex> lock(reader_mutex_);
+  return get_window(total_histogram_).summary();
 }
 
 std::vector<double> OneMeasurementHdrHistogram::get_percentile_values(const std::string& s) {
@@ -264,12 +357,18 @@ std::vector<double> OneMeasurementHdrHistogram::get_percentile_values(const std:
 }
 
 struct hdr_histogram* OneMeasurementHdrHistogram::get_interval_histogram_and_accumulate() {
-  struct hdr_histogram* interval_histogram = hdr_interval_recorder_sample(&histogram_);
-  if (!total_histogram_)
-    total_histogram_ = copy(interval_histogram);
+  if (!interval_histogram_)
+    hdr_init(1, 1000000, 3, &interval_histogram_);
   else
-    hdr_add(total_histogram_, interval_histogram);
-  return interval_histogram;
+    hdr_reset(interval_histogram_);
+  shards_.for_each([this](Shard* shard) {
+    hdr_add(interval_histogram_, hdr_interval_recorder_sample(&shard->histogram_));
+  });
+
+  if (!total_histogram_)
+    hdr_init(1, 1000000, 3, &total_histogram_);
+  hdr_add(total_histogram_, interval_histogram_);
+  return interval_histogram_;
 }
 
 std::string OneMeasurementHdrHistogram::ordinal(double i) {
@@ -288,29 +387,6 @@ std::string OneMeasurementHdrHistogram::ordinal(double i) {
     return std::to_string(i);
 }
 
-hdr_histogram* OneMeasurementHdrHistogram::copy(hdr_histogram* hdr) {
-  hdr_histogram* histogram = (struct hdr_histogram*) calloc(1, sizeof(struct hdr_histogram));
-  histogram->lowest_trackable_value = hdr->lowest_trackable_value;
-  histogram->highest_trackable_value = hdr->highest_trackable_value;
-  histogram->unit_magnitude = hdr->unit_magnitude;
-  histogram->significant_figures = hdr->significant_figures;
-  histogram->sub_bucket_half_count_magnitude = hdr->sub_bucket_half_count_magnitude;
-  histogram->sub_bucket_half_count = hdr->sub_bucket_half_count;
-  histogram->sub_bucket_mask = hdr->sub_bucket_mask;
-  histogram->sub_bucket_count = hdr->sub_bucket_count;
-  histogram->bucket_count = hdr->bucket_count;
-  histogram->min_value = hdr->min_value;
-  histogram->max_value = hdr->max_value;
-  histogram->normalizing_index_offset = hdr->normalizing_index_offset;
-  histogram->conversion_ratio = hdr->conversion_ratio;
-  histogram->counts_len = hdr->counts_len;
-  histogram->total_count = hdr->total_count;
-  int64_t* counts = (int64_t*) calloc((size_t) hdr->counts_len, sizeof(int64_t));
-  histogram->counts = counts;
-  memcpy(histogram->counts, hdr->counts, (size_t) hdr->counts_len * sizeof(int64_t));
-  return histogram;
-}
-
 thread_local Measurements::StartTimerHolder Measurements::intended_start_time_;
 utils::Properties Measurements::props_;
 
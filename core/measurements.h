@@ -7,6 +7,9 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <sys/time.h>
@@ -50,35 +53,168 @@ private:
   std::string buf_;
 };
 
+///
+/// Every thread that records a measurement is handed a small dense id the
+/// first time it does so; the id indexes the per-thread shards below.
+///
+const int kMaxMeasurementThreads = 1024;
+
+inline int measurement_thread_id() {
+  static std::atomic<int> next_id(0);
+  thread_local int id = next_id.fetch_add(1);
+  if (id >= kMaxMeasurementThreads)
+    throw utils::Exception("Too many threads recording measurements");
+  return id;
+}
+
+///
+/// Adds to a counter that only the calling thread ever writes. A relaxed
+/// load and store is enough and avoids a locked read-modify-write.
+///
+template <typename T>
+inline void add_relaxed(std::atomic<T>& counter, T n) {
+  counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+///
+/// Per-thread shards of recording state. A shard is written only by the
+/// thread that owns it, so recording takes no lock and does no shared
+/// writes; readers walk all shards and merge them.
+///
+template <typename Shard>
+class ThreadShards {
+public:
+  ThreadShards(): shards_(new std::atomic<Shard*>[kMaxMeasurementThreads]) {
+    for (int i = 0; i < kMaxMeasurementThreads; i++)
+      shards_[i].store(nullptr, std::memory_order_relaxed);
+  }
+  ~ThreadShards() {
+    for (int i = 0; i < kMaxMeasurementThreads; i++)
+      delete shards_[i].load(std::memory_order_relaxed);
+  }
+  ThreadShards(const ThreadShards&) = delete;
+  void operator=(const ThreadShards&) = delete;
+
+  // The calling thread's shard, built by create() on first use.
+  template <typename Create>
+  Shard* local(Create create) {
+    std::atomic<Shard*>& slot = shards_[measurement_thread_id()];
+    Shard* shard = slot.load(std::memory_order_relaxed);
+    if (shard == nullptr) {
+      shard = create();
+      slot.store(shard, std::memory_order_release);
+    }
+    return shard;
+  }
+
+  template <typename Visit>
+  void for_each(Visit visit) const {
+    for (int i = 0; i < kMaxMeasurementThreads; i++) {
+      Shard* shard = shards_[i].load(std::memory_order_acquire);
+      if (shard != nullptr)
+        visit(shard);
+    }
+  }
+
+private:
+  std::unique_ptr<std::atomic<Shard*>[]> shards_;
+};
+
+///
+/// Statistics of one measurement over the interval since its previous
+/// summary. Latencies are in microseconds; fields a measurement type does
+/// not track per interval are -1.
+///
+struct MeasurementWindow {
+  std::string name;
+  uint64_t operations = 0;
+  double average = 0;
+  int64_t min = -1;
+  int64_t max = -1;
+  int64_t p50 = -1;
+  int64_t p90 = -1;
+  int64_t p99 = -1;
+  int64_t p999 = -1;
+  int64_t p9999 = -1;
+
+  std::string summary() const {
+    std::stringstream ss(std::stringstream::in | std::stringstream::out);
+    ss << std::fixed << std::setprecision(2) << "[" << name << ": Count=" << operations;
+    if (max >= 0)
+      ss << ", Max=" << max << ", Min=" << min;
+    ss << ", Avg=" << average;
+    if (p50 >= 0)
+      ss << ", 50=" << p50 << ", 90=" << p90 << ", 99=" << p99
+         << ", 99.9=" << p999 << ", 99.99=" << p9999;
+    ss << "]";
+    return ss.str();
+  }
+};
+
 class OneMeasurement {
 public:
   OneMeasurement(const std::string& name): name_(name) {}
 
+  virtual ~OneMeasurement() {}
+
   std::string get_name() { return name_; }
 
   void report_status(int status) {
-    WriteLock lock(&rwlock_);
-    std::unordered_map<int, std::atomic<int>>::iterator counter = return_codes_.find(status);
-    if (counter != return_codes_.end())
-      counter->second.fetch_add(1);
-    else
-      return_codes_.emplace(status, 1);
+    if (status >= 0 && status < kStatusCodes) {
+      StatusShard* shard = status_shards_.local([]() { return new StatusShard(); });
+      add_relaxed(shard->counts[status], (uint64_t)(1));
+    }
+    else {
+      std::lock_guard<std::mutex> lock(other_status_mutex_);
+      other_return_codes_[status]++;
+    }
   }
 
   void export_status_counts(MeasurementsExporter* exporter) {
-    ReadLock lock(&rwlock_);
-    for (auto& p : return_codes_)
-      exporter->write(name_, "Return=" + std::to_string(p.first), p.second.load());
+    std::map<int, uint64_t> counts;
+    status_shards_.for_each([&counts](StatusShard* shard) {
+      for (int i = 0; i < kStatusCodes; i++) {
+        uint64_t n = shard->counts[i].load(std::memory_order_relaxed);
+        if (n > 0)
+          counts[i] += n;
+      }
+    });
+    {
+      std::lock_guard<std::mutex> lock(other_status_mutex_);
+      for (auto& p : other_return_codes_)
+        counts[p.first] += p.second;
+    }
+    for (auto& p : counts)
+      exporter->write(name_, "Return=" + std::to_string(p.first), p.second);
   }
 
   virtual void measure(int latency)=0;
+  // Starts a new interval: the next call only covers what was measured
+  // after this one.
+  virtual MeasurementWindow get_window()=0;
+  // Summarizes all that was measured, whatever the intervals reported.
   virtual std::string get_summary()=0;
   virtual void export_measurements(MeasurementsExporter* exporter)=0;
+  // Called when Measurements::reset() retires the measurement, before a
+  // new one of the same name may be created.
+  virtual void retire() {}
 
 private:
+  // Return codes of DB (see core/db.h) are small; anything else is rare and
+  // counted under a lock.
+  static const int kStatusCodes = 16;
+  struct StatusShard {
+    StatusShard() {
+      for (int i = 0; i < kStatusCodes; i++)
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+    std::atomic<uint64_t> counts[kStatusCodes];
+  };
+
   std::string name_;
-  std::unordered_map<int, std::atomic<int>> return_codes_;
-  mutable RWMutex rwlock_;
+  ThreadShards<StatusShard> status_shards_;
+  std::map<int, uint64_t> other_return_codes_;
+  std::mutex other_status_mutex_;
 };
 
 class OneMeasurementRaw: public OneMeasurement {
@@ -110,6 +246,8 @@ public:
 
   virtual void export_measurements(MeasurementsExporter* exporter) override;
 
+  virtual MeasurementWindow get_window() override;
+
   virtual std::string get_summary() override;
 
 public:
@@ -133,16 +271,24 @@ public:
   std::string NO_SUMMARY_STATS_DEFAULT = "false";
 
 private:
+  // Data points of one thread. The points are only read by
+  // export_measurements(), once the recording threads are done.
+  struct Shard {
+    std::vector<RawDataPoint> measurements_;
+    std::atomic<uint64_t> operations_{0};
+    std::atomic<uint64_t> total_latency_{0};
+  };
+
   std::ofstream f_;
   bool no_summary_stats_ = false;
-  std::vector<RawDataPoint> measurements_;
-  uint64_t total_latency = 0;
+  ThreadShards<Shard> shards_;
 
   // A window of stats to print summary for at the next getSummary() call.
   // It's supposed to be a one line summary, so we will just print count and
-  // average.
-  int window_operations_ = 0;
-  uint64_t window_total_latency_ = 0;
+  // average. The window is the difference from the totals seen last time.
+  std::mutex window_mutex_;
+  uint64_t window_base_operations_ = 0;
+  uint64_t window_base_latency_ = 0;
 };
 
 class OneMeasurementHistogram: public OneMeasurement {
@@ -153,6 +299,8 @@ public:
 
   virtual void export_measurements(MeasurementsExporter* exporter) override;
 
+  virtual MeasurementWindow get_window() override;
+
   virtual std::string get_summary() override;
 
 public:
@@ -161,19 +309,29 @@ public:
   std::string VERBOSE_PROPERTY = "measurement.histogram.verbose";
 
 private:
+  // Buckets and totals of one thread.
+  struct Shard {
+    Shard(int buckets): histogram_(new std::atomic<uint64_t>[buckets]) {
+      for (int i = 0; i < buckets; i++)
+        histogram_[i].store(0, std::memory_order_relaxed);
+    }
+    std::unique_ptr<std::atomic<uint64_t>[]> histogram_;
+    // Counts all operations outside the histogram's range.
+    std::atomic<uint64_t> histogram_overflow_{0};
+    std::atomic<uint64_t> operations_{0};
+    std::atomic<uint64_t> total_latency_{0};
+    std::atomic<double> total_squared_latency_{0};
+    std::atomic<int> min_{-1};
+    std::atomic<int> max_{-1};
+  };
+
   int buckets_;
-  std::vector<uint64_t> histogram_;
-  // Counts all operations outside the histogram's range.
-  uint64_t histogram_overflow_;
-  uint64_t operations_;
-  uint64_t total_latency_;
-  double total_squared_latency_;
+  ThreadShards<Shard> shards_;
   // Whether or not to emit the histogram buckets.
   bool verbose_;
-  uint64_t window_operations_;
-  uint64_t window_total_latency_;
-  int min_;
-  int max_;
+  std::mutex window_mutex_;
+  uint64_t window_base_operations_;
+  uint64_t window_base_latency_;
 };
 
 class OneMeasurementHdrHistogram: public OneMeasurement {
@@ -186,16 +344,23 @@ public:
 
   virtual void export_measurements(MeasurementsExporter* exporter) override;
 
+  virtual MeasurementWindow get_window() override;
+
   virtual std::string get_summary() override;
 
+  // Closes the log, which the new measurement of the name writes afresh.
+  virtual void retire() override;
+
 private:
   std::vector<double> get_percentile_values(const std::string& s);
 
+  // Samples every thread's recorder into interval_histogram_ and adds it to
+  // total_histogram_. Callers hold reader_mutex_.
   struct hdr_histogram* get_interval_histogram_and_accumulate();
 
-  std::string ordinal(double i);
+  MeasurementWindow get_window(struct hdr_histogram* histogram);
 
-  hdr_histogram* copy(hdr_histogram* hdr);
+  std::string ordinal(double i);
 
 public:
   std::string PERCENTILES_PROPERTY = "hdrhistogram.percentiles";
@@ -203,15 +368,59 @@ public:
   std::string VERBOSE_PROPERTY = "measurement.histogram.verbose";
 
 private:
+  // The recorder of one thread. Only its owner records into it; readers
+  // swap out the active histogram under the recorder's phaser.
+  struct Shard {
+    Shard() { hdr_interval_recorder_init_all(&histogram_, 1, 1000000, 3); }
+    ~Shard() { hdr_interval_recorder_destroy(&histogram_); }
+    struct hdr_interval_recorder histogram_;
+  };
+
   FILE* log_;
   struct hdr_log_writer histogram_log_writer_;
+  std::mutex reader_mutex_;
+  struct hdr_histogram* interval_histogram_;
   struct hdr_histogram* total_histogram_;
-  struct hdr_interval_recorder histogram_;
+  ThreadShards<Shard> shards_;
   hdr_timespec base_time_;
   bool verbose_;
   std::vector<double> percentiles_;
 };
 
+///
+/// Operations measured by DBWrapper and Client. Each one has fixed slots in
+/// Measurements, so recording a latency neither builds nor hashes a name.
+///
+enum OperationId {
+  OP_READ,
+  OP_UPDATE,
+  OP_SCAN,
+  OP_INSERT,
+  OP_DELETE,
+  OP_READ_MODIFY_WRITE,
+  OP_MULTI_READ,
+  OP_BATCH_INSERT,
+  OP_TRANSACTION,
+  OP_CLEANUP,
+  NUM_OPERATION_IDS
+};
+
+inline const char* operation_name(OperationId op) {
+  static const char* const names[NUM_OPERATION_IDS] = {
+    "READ",
+    "UPDATE",
+    "SCAN",
+    "INSERT",
+    "DELETE",
+    "READ-MODIFY-WRITE",
+    "MULTI-READ",
+    "BATCH-INSERT",
+    "TRANSACTION",
+    "CLEANUP"
+  };
+  return names[op];
+}
+
 class Measurements {
 public:
   enum MeasurementType {
@@ -255,7 +464,30 @@ public:
       return 0;
     return intended_start_time_.start_time();
   }
+  // The intended start time set for the calling thread, or zero if it runs
+  // closed-loop.
+  uint64_t get_set_intended_start_time_ns() { return intended_start_time_.time_; }
+
+  void measure(OperationId op, bool failed, int latency) {
+    if (measurement_interval_ == 1)
+      return;
+    get_op_measurement(op, failed)->measure(latency);
+  }
+
+  void measure_intended(OperationId op, bool failed, int latency) {
+    if (measurement_interval_ == 0)
+      return;
+    get_op_intended_measurement(op, failed)->measure(latency);
+  }
 
+  void report_status(OperationId op, int status) {
+    OneMeasurement* m = (measurement_interval_ == 1?
+        get_op_intended_measurement(op, false) : get_op_measurement(op, false));
+    m->report_status(status);
+  }
+
+  // Measurements by name, for operations without an OperationId. Names of
+  // known operations ("READ", "READ-FAILED", ...) resolve to their slots.
   void measure(const std::string& operation, int latency) {
     if (measurement_interval_ == 1)
       return;
@@ -277,11 +509,13 @@ public:
   }
 
   void export_measurements(MeasurementsExporter* exporter) {
+    for_each_slot(op_slots_, [exporter](OneMeasurement* m) { m->export_measurements(exporter); });
     {
       ReadLock lock(&lock1_);
       for (auto& it : op_to_measurement_map_)
         it.second->export_measurements(exporter);
     }
+    for_each_slot(intended_op_slots_, [exporter](OneMeasurement* m) { m->export_measurements(exporter); });
     {
       ReadLock lock(&lock2_);
       for (auto& it : op_to_intended_measurement_map_)
@@ -289,13 +523,67 @@ public:
     }
   }
 
+  std::vector<MeasurementWindow> get_windows() {
+    std::vector<MeasurementWindow> windows;
+    for_each_slot(op_slots_, [&windows](OneMeasurement* m) { windows.push_back(m->get_window()); });
+    {
+      ReadLock lock(&lock1_);
+      for (auto& it : op_to_measurement_map_)
+        windows.push_back(it.second->get_window());
+    }
+    for_each_slot(intended_op_slots_, [&windows](OneMeasurement* m) { windows.push_back(m->get_window()); });
+    {
+      ReadLock lock(&lock2_);
+      for (auto& it : op_to_intended_measurement_map_)
+        windows.push_back(it.second->get_window());
+    }
+    return windows;
+  }
+
+  // Starts measuring afresh, e.g. at the end of a warm-up phase. The current
+  // measurements are retired rather than freed, so clients may keep
+  // recording meanwhile; a latency racing with the reset can still land in
+  // a retired measurement and is then dropped.
+  void reset() {
+    std::lock_guard<std::mutex> lock(slot_mutex_);
+    for (int i = 0; i < NUM_OPERATION_IDS; i++) {
+      for (int failed = 0; failed < 2; failed++) {
+        for (std::atomic<OneMeasurement*>* slot :
+             {&op_slots_[i][failed], &intended_op_slots_[i][failed]}) {
+          OneMeasurement* m = slot->exchange(nullptr, std::memory_order_acq_rel);
+          if (m != nullptr)
+            m->retire();
+        }
+      }
+    }
+    {
+      WriteLock map_lock(&lock1_);
+      for (auto& it : op_to_measurement_map_) {
+        it.second->retire();
+        slot_measurements_.push_back(std::move(it.second));
+      }
+      op_to_measurement_map_.clear();
+    }
+    {
+      WriteLock map_lock(&lock2_);
+      for (auto& it : op_to_intended_measurement_map_) {
+        it.second->retire();
+        slot_measurements_.push_back(std::move(it.second));
+      }
+      op_to_intended_measurement_map_.clear();
+    }
+    generation_.fetch_add(1, std::memory_order_release);
+  }
+
   std::string get_summary() {
     std::string ret;
+    for_each_slot(op_slots_, [&ret](OneMeasurement* m) { ret.append(m->get_summary() + " "); });
     {
       ReadLock lock(&lock1_);
       for (auto& it : op_to_measurement_map_)
         ret.append(it.second->get_summary() + " ");
     }
+    for_each_slot(intended_op_slots_, [&ret](OneMeasurement* m) { ret.append(m->get_summary() + " "); });
     {
       ReadLock lock(&lock2_);
       for (auto& it : op_to_intended_measurement_map_)
@@ -305,7 +593,14 @@ public:
   }
 
 private:
-  Measurements() {
+  Measurements(): generation_(0), measurement_type_(HDRHISTOGRAM), measurement_interval_(0) {
+    for (int i = 0; i < NUM_OPERATION_IDS; i++) {
+      for (int failed = 0; failed < 2; failed++) {
+        op_slots_[i][failed].store(nullptr, std::memory_order_relaxed);
+        intended_op_slots_[i][failed].store(nullptr, std::memory_order_relaxed);
+      }
+    }
+
     std::string type_string = props_.GetProperty(MEASUREMENT_TYPE_PROPERTY, MEASUREMENT_TYPE_PROPERTY_DEFAULT);
     if (type_string == "histogram")
       measurement_type_ = HISTOGRAM;
@@ -340,31 +635,165 @@ private:
     return nullptr;
   }
 
+  typedef std::atomic<OneMeasurement*> OperationSlots[NUM_OPERATION_IDS][2];
+
+  OneMeasurement* get_op_measurement(OperationId op, bool failed) {
+    OneMeasurement* m = op_slots_[op][failed].load(std::memory_order_acquire);
+    if (m == nullptr) {
+      std::string name = operation_name(op);
+      m = create_slot(&op_slots_[op][failed], failed? name + "-FAILED" : name);
+    }
+    return m;
+  }
+
+  OneMeasurement* get_op_intended_measurement(OperationId op, bool failed) {
+    OneMeasurement* m = intended_op_slots_[op][failed].load(std::memory_order_acquire);
+    if (m == nullptr) {
+      std::string name = operation_name(op);
+      if (failed)
+        name += "-FAILED";
+      m = create_slot(&intended_op_slots_[op][failed],
+          measurement_interval_ == 1? name : "Intended-" + name);
+    }
+    return m;
+  }
+
+  OneMeasurement* create_slot(std::atomic<OneMeasurement*>* slot, const std::string& name) {
+    std::lock_guard<std::mutex> lock(slot_mutex_);
+    OneMeasurement* m = slot->load(std::memory_order_relaxed);
+    if (m == nullptr) {
+      slot_measurements_.push_back(construct_onemeasurement(name));
+      m = slot_measurements_.back().get();
+      slot->store(m, std::memory_order_release);
+    }
+    return m;
+  }
+
+  template <typename Visit>
+  void for_each_slot(OperationSlots& slots, Visit visit) {
+    for (int i = 0; i < NUM_OPERATION_IDS; i++) {
+      for (int failed = 0; failed < 2; failed++) {
+        OneMeasurement* m = slots[i][failed].load(std::memory_order_acquire);
+        if (m != nullptr)
+          visit(m);
+      }
+    }
+  }
+
+  // Resolves the name of a known operation, with or without the "-FAILED"
+  // suffix, to its OperationId.
+  static bool find_operation(const std::string& name, OperationId* op, bool* failed) {
+    static const std::string kFailedSuffix = "-FAILED";
+    for (int i = 0; i < NUM_OPERATION_IDS; i++) {
+      const std::string op_name = operation_name((OperationId)(i));
+      if (name == op_name) {
+        *op = (OperationId)(i);
+        *failed = false;
+        return true;
+      }
+      if (name == op_name + kFailedSuffix) {
+        *op = (OperationId)(i);
+        *failed = true;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Measurements are only retired by reset(), so each thread caches the ones
+  // it has looked up and only touches the shared maps the first time after
+  // each reset.
+  struct NameCache {
+    uint64_t generation = 0;
+    std::unordered_map<std::string, OneMeasurement*> measurements;
+
+    std::unordered_map<std::string, OneMeasurement*>& get(const std::atomic<uint64_t>& current) {
+      uint64_t g = current.load(std::memory_order_acquire);
+      if (g != generation) {
+        measurements.clear();
+        generation = g;
+      }
+      return measurements;
+    }
+  };
+
   OneMeasurement* get_op_measurement(const std::string& operation) {
-    WriteLock lock(&lock1_);
-    auto it = op_to_measurement_map_.find(operation);
-    if (it == op_to_measurement_map_.end()) {
-      op_to_measurement_map_[operation] = construct_onemeasurement(operation);
+    thread_local NameCache name_cache;
+    std::unordered_map<std::string, OneMeasurement*>& cache = name_cache.get(generation_);
+    auto cached = cache.find(operation);
+    if (cached != cache.end())
+      return cached->second;
+
+    OperationId op;
+    bool failed;
+    if (find_operation(operation, &op, &failed)) {
+      OneMeasurement* m = get_op_measurement(op, failed);
+      cache.emplace(operation, m);
+      return m;
+    }
+
+    OneMeasurement* m = nullptr;
+    {
+      ReadLock lock(&lock1_);
+      auto it = op_to_measurement_map_.find(operation);
+      if (it != op_to_measurement_map_.end())
+        m = it->second.get();
+    }
+    if (m == nullptr) {
+      WriteLock lock(&lock1_);
+      auto it = op_to_measurement_map_.find(operation);
+      if (it == op_to_measurement_map_.end()) {
+        op_to_measurement_map_[operation] = construct_onemeasurement(operation);
+      }
+      m = op_to_measurement_map_[operation].get();
     }
-    return op_to_measurement_map_[operation].get();
+    cache.emplace(operation, m);
+    return m;
   }
 
   OneMeasurement* get_op_intended_measurement(const std::string& operation) {
-    WriteLock lock(&lock2_);
-    auto it = op_to_intended_measurement_map_.find(operation);
-    if (it == op_to_intended_measurement_map_.end()) {
-      std::string name = (measurement_interval_ == 1? operation : "Intended-" + operation);
-      op_to_intended_measurement_map_[operation] = construct_onemeasurement(name);
+    thread_local NameCache name_cache;
+    std::unordered_map<std::string, OneMeasurement*>& cache = name_cache.get(generation_);
+    auto cached = cache.find(operation);
+    if (cached != cache.end())
+      return cached->second;
+
+    OperationId op;
+    bool failed;
+    if (find_operation(operation, &op, &failed)) {
+      OneMeasurement* m = get_op_intended_measurement(op, failed);
+      cache.emplace(operation, m);
+      return m;
     }
-    return op_to_intended_measurement_map_[operation].get();
+
+    OneMeasurement* m = nullptr;
+    {
+      ReadLock lock(&lock2_);
+      auto it = op_to_intended_measurement_map_.find(operation);
+      if (it != op_to_intended_measurement_map_.end())
+        m = it->second.get();
+    }
+    if (m == nullptr) {
+      WriteLock lock(&lock2_);
+      auto it = op_to_intended_measurement_map_.find(operation);
+      if (it == op_to_intended_measurement_map_.end()) {
+        std::string name = (measurement_interval_ == 1? operation : "Intended-" + operation);
+        op_to_intended_measurement_map_[operation] = construct_onemeasurement(name);
+      }
+      m = op_to_intended_measurement_map_[operation].get();
+    }
+    cache.emplace(operation, m);
+    return m;
   }
 
   struct StartTimerHolder {
     uint64_t time_ = 0;
 
+    // The intended start time set by a throttled client, or the current
+    // time when the client runs closed-loop.
     uint64_t start_time() {
-      if (time_)
-        return std::chrono::duration_cast<std::chrono::milliseconds>(
+      if (time_ == 0)
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
             std::chrono::system_clock::now().time_since_epoch()).count();
       else
         return time_;
@@ -373,6 +802,13 @@ private:
 
   thread_local static StartTimerHolder intended_start_time_;
 
+  OperationSlots op_slots_;
+  OperationSlots intended_op_slots_;
+  // Owns every measurement in a slot, and those retired by reset().
+  std::vector<std::unique_ptr<OneMeasurement>> slot_measurements_;
+  std::mutex slot_mutex_;
+  std::atomic<uint64_t> generation_;
+
   std::unordered_map<std::string, std::unique_ptr<OneMeasurement>> op_to_measurement_map_;
   mutable RWMutex lock1_;
   std::unordered_map<std::string, std::unique_ptr<OneMeasurement>> op_to_intended_measurement_map_;
@@ -30,6 +30,9 @@ class ScrambledZipfianGenerator : public Generator<uint64_t> {
   
   uint64_t Next();
   uint64_t Last();
+  ScrambledZipfianGenerator *Clone() const {
+    return new ScrambledZipfianGenerator(*this);
+  }
   
  private:
   const uint64_t base_;
@@ -27,10 +27,12 @@ class SkewedLatestGenerator : public Generator<uint64_t> {
   
   uint64_t Next();
   uint64_t Last() { return last_; }
+  /// The clone still follows the same counter.
+  SkewedLatestGenerator *Clone() const { return new SkewedLatestGenerator(*this); }
  private:
   CounterGenerator &basis_;
   ZipfianGenerator zipfian_;
-  std::atomic<uint64_t> last_;
+  uint64_t last_;
 };
 
 inline uint64_t SkewedLatestGenerator::Next() {
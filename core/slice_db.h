@@ -0,0 +1,175 @@
+//
+//  slice_db.h
+//  YCSB-C
+//
+
+#ifndef YCSB_C_SLICE_DB_H_
+#define YCSB_C_SLICE_DB_H_
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace ycsbc {
+
+///
+/// A non-owning view of bytes; it is valid as long as what it points to.
+///
+class Slice {
+ public:
+  Slice() : data_(""), size_(0) { }
+  Slice(const char *data, size_t size) : data_(data), size_(size) { }
+  Slice(const std::string &s) : data_(s.data()), size_(s.size()) { }
+  Slice(const char *s) : data_(s), size_(strlen(s)) { }
+
+  const char *data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  std::string ToString() const { return std::string(data_, size_); }
+
+  bool operator==(const Slice &other) const {
+    return size_ == other.size_ && memcmp(data_, other.data_, size_) == 0;
+  }
+  bool operator!=(const Slice &other) const { return !(*this == other); }
+
+ private:
+  const char *data_;
+  size_t size_;
+};
+
+///
+/// Receives the records of a SliceDB::StreamScan() as they are read. The
+/// views are only valid during the call.
+///
+class ScanVisitor {
+ public:
+  /// Called for each selected field of the current record.
+  virtual void Field(const Slice &field, const Slice &value) = 0;
+  /// Called after the fields of each record.
+  virtual void EndRecord() = 0;
+
+  virtual ~ScanVisitor() { }
+};
+
+///
+/// Field/value pairs of the records returned by a SliceDB read, packed into
+/// one buffer owned by the caller. Clear() keeps the memory, so a buffer
+/// reused across operations stops allocating once it has grown.
+///
+class ResultBuffer : public ScanVisitor {
+ public:
+  void Clear() {
+    bytes_.clear();
+    fields_.clear();
+    records_.clear();
+  }
+
+  void Append(const Slice &field, const Slice &value) {
+    Entry e;
+    e.field_offset = bytes_.size();
+    e.field_size = field.size();
+    bytes_.insert(bytes_.end(), field.data(), field.data() + field.size());
+    e.value_offset = bytes_.size();
+    e.value_size = value.size();
+    bytes_.insert(bytes_.end(), value.data(), value.data() + value.size());
+    fields_.push_back(e);
+  }
+
+  ///
+  /// Ends a record of a scan; the fields appended since the previous record
+  /// belong to it.
+  ///
+  void EndRecord() { records_.push_back(fields_.size()); }
+
+  void Field(const Slice &field, const Slice &value) { Append(field, value); }
+
+  size_t num_fields() const { return fields_.size(); }
+  size_t num_records() const { return records_.size(); }
+
+  /// The views are valid until the buffer is next modified.
+  Slice field(size_t i) const {
+    return Slice(bytes_.data() + fields_[i].field_offset, fields_[i].field_size);
+  }
+  Slice value(size_t i) const {
+    return Slice(bytes_.data() + fields_[i].value_offset, fields_[i].value_size);
+  }
+
+  /// Fields [record_begin(r), record_end(r)) belong to record r of a scan.
+  size_t record_begin(size_t r) const { return r == 0 ? 0 : records_[r - 1]; }
+  size_t record_end(size_t r) const { return records_[r]; }
+
+ private:
+  struct Entry {
+    size_t field_offset;
+    size_t field_size;
+    size_t value_offset;
+    size_t value_size;
+  };
+
+  std::vector<char> bytes_;
+  std::vector<Entry> fields_;
+  std::vector<size_t> records_;
+};
+
+///
+/// An optional interface of a DB binding that takes keys and values as
+/// views and returns results in a ResultBuffer, so the client does not
+/// build or copy strings per operation. A binding offers it through
+/// DB::GetSliceDB(); the semantics and return codes are those of DB.
+///
+class SliceDB {
+ public:
+  typedef std::pair<Slice, Slice> SliceKVPair;
+
+  virtual int Read(const std::string &table, const Slice &key,
+                   const std::vector<Slice> *fields,
+                   ResultBuffer &result) = 0;
+  ///
+  /// Reads a batch of records; record i of result belongs to keys[i] and
+  /// is empty if its read failed. Defaults to a Read() per key.
+  ///
+  virtual int MultiRead(const std::string &table, const std::vector<Slice> &keys,
+                        const std::vector<Slice> *fields, ResultBuffer &result,
+                        std::vector<int> &statuses) {
+    statuses.assign(keys.size(), 0);
+    int res = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      statuses[i] = Read(table, keys[i], fields, result);
+      result.EndRecord();
+      if (res == 0)
+        res = statuses[i];
+    }
+    return res;
+  }
+  virtual int Scan(const std::string &table, const Slice &key,
+                   int record_count, const std::vector<Slice> *fields,
+                   ResultBuffer &result) = 0;
+  ///
+  /// Scans like Scan(), but hands the records to visitor as they are read
+  /// instead of collecting them. Defaults to a Scan() into a buffer.
+  ///
+  virtual int StreamScan(const std::string &table, const Slice &key,
+                         int record_count, const std::vector<Slice> *fields,
+                         ScanVisitor &visitor) {
+    thread_local ResultBuffer result;
+    result.Clear();
+    int res = Scan(table, key, record_count, fields, result);
+    for (size_t r = 0; r < result.num_records(); ++r) {
+      for (size_t i = result.record_begin(r); i < result.record_end(r); ++i)
+        visitor.Field(result.field(i), result.value(i));
+      visitor.EndRecord();
+    }
+    return res;
+  }
+  virtual int Update(const std::string &table, const Slice &key,
+                     const std::vector<SliceKVPair> &values) = 0;
+  virtual int Insert(const std::string &table, const Slice &key,
+                     const std::vector<SliceKVPair> &values) = 0;
+  virtual int Delete(const std::string &table, const Slice &key) = 0;
+
+  virtual ~SliceDB() { }
+};
+
+} // ycsbc
+
+#endif // YCSB_C_SLICE_DB_H_
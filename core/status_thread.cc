@@ -0,0 +1,191 @@
+//
+//  status_thread.cc
+//  YCSB-C
+//
+
+#include "core/status_thread.h"
+
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include "core/timer.h"
+#include "core/utils.h"
+
+using std::string;
+using ycsbc::StatusThread;
+
+const string StatusThread::INTERVAL_PROPERTY = "status.interval";
+const string StatusThread::INTERVAL_DEFAULT = "0";
+
+const string StatusThread::FILE_PROPERTY = "status.file";
+const string StatusThread::FILE_DEFAULT = "";
+
+const string StatusThread::FORMAT_PROPERTY = "status.format";
+const string StatusThread::FORMAT_DEFAULT = "csv";
+
+class StatusThread::StatsCollector : public ycsbc::MeasurementsExporter {
+ public:
+  std::vector<Stat> stats;
+
+  void write(const string &metric, const string &measurement, int i) override {
+    stats.push_back(Stat{metric, measurement, std::to_string(i)});
+  }
+  void write(const string &metric, const string &measurement, uint64_t i) override {
+    stats.push_back(Stat{metric, measurement, std::to_string(i)});
+  }
+  void write(const string &metric, const string &measurement, double i) override {
+    stats.push_back(Stat{metric, measurement, std::to_string(i)});
+  }
+};
+
+StatusThread::StatusThread(const utils::Properties &props,
+                           const std::vector<ClientProgress> &progress, DB *db) :
+    progress_(progress), db_(db), json_(false), stop_(false),
+    start_ns_(0), last_ns_(0), last_ops_(0) {
+  interval_ms_ = (uint64_t)(1000 * std::stod(props.GetProperty(
+      INTERVAL_PROPERTY, INTERVAL_DEFAULT)));
+
+  string format = props.GetProperty(FORMAT_PROPERTY, FORMAT_DEFAULT);
+  if (format == "json") {
+    json_ = true;
+  } else if (format != "csv") {
+    throw utils::Exception("Unknown status format: " + format);
+  }
+
+  string path = props.GetProperty(FILE_PROPERTY, FILE_DEFAULT);
+  if (enabled() && !path.empty()) {
+    file_.open(path);
+    if (!file_.is_open())
+      throw utils::Exception("Failed to open status file: " + path);
+    if (!json_) {
+      file_ << "timestamp_ms,elapsed_sec,operations,ops_per_sec,"
+            << "measurement,count,avg_us,min_us,max_us,p50_us,p99_us,p999_us"
+            << std::endl;
+    }
+  }
+}
+
+void StatusThread::Start() {
+  if (!enabled())
+    return;
+  start_ns_ = last_ns_ = utils::NowNanos();
+  thread_ = std::thread(&StatusThread::Run, this);
+}
+
+void StatusThread::Stop() {
+  if (!thread_.joinable())
+    return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+  Report();
+}
+
+void StatusThread::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto deadline = std::chrono::steady_clock::now();
+  while (true) {
+    deadline += std::chrono::milliseconds(interval_ms_);
+    if (cv_.wait_until(lock, deadline, [this] { return stop_; }))
+      return;
+    lock.unlock();
+    Report();
+    lock.lock();
+  }
+}
+
+void StatusThread::Report() {
+  uint64_t now_ns = utils::NowNanos();
+  uint64_t ops = 0;
+  for (const ClientProgress &p : progress_)
+    ops += p.ops_done.load(std::memory_order_relaxed);
+
+  double elapsed = (now_ns - start_ns_) / 1e9;
+  double interval = (now_ns - last_ns_) / 1e9;
+  double ops_per_sec = interval > 0 ? (ops - last_ops_) / interval : 0;
+  last_ns_ = now_ns;
+  last_ops_ = ops;
+
+  std::vector<MeasurementWindow> windows =
+      Measurements::get_measurements().get_windows();
+  StatsCollector collector;
+  if (db_ != NULL)
+    db_->ExportStats(&collector);
+  const std::vector<Stat> &stats = collector.stats;
+
+  time_t now_sec = now_ns / 1000000000;
+  struct tm tm;
+  localtime_r(&now_sec, &tm);
+  char date[32];
+  strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &tm);
+
+  char head[128];
+  snprintf(head, sizeof(head), "%s:%03d %.0f sec: %lu operations; %.2f current ops/sec;",
+      date, (int)(now_ns / 1000000 % 1000), elapsed, ops, ops_per_sec);
+  string line = head;
+  for (const MeasurementWindow &w : windows) {
+    if (w.operations > 0)
+      line.append(" " + w.summary());
+  }
+  // Statistics of one metric are written together: [METRIC: a=1, b=2].
+  for (size_t i = 0; i < stats.size(); i++) {
+    bool first = i == 0 || stats[i].metric != stats[i - 1].metric;
+    bool last = i + 1 == stats.size() || stats[i].metric != stats[i + 1].metric;
+    line.append(first ? " [" + stats[i].metric + ": " : ", ");
+    line.append(stats[i].measurement + "=" + stats[i].value);
+    if (last)
+      line.append("]");
+  }
+  std::cerr << line << std::endl;
+
+  if (file_.is_open())
+    WriteFile(now_ns / 1000000, elapsed, ops, ops_per_sec, windows, stats);
+}
+
+void StatusThread::WriteFile(uint64_t now_ms, double elapsed, uint64_t ops,
+                             double ops_per_sec,
+                             const std::vector<MeasurementWindow> &windows,
+                             const std::vector<Stat> &stats) {
+  if (json_) {
+    file_ << "{\"timestamp_ms\":" << now_ms << ",\"elapsed_sec\":" << elapsed
+          << ",\"operations\":" << ops << ",\"ops_per_sec\":" << ops_per_sec
+          << ",\"measurements\":{";
+    bool first = true;
+    for (const MeasurementWindow &w : windows) {
+      file_ << (first ? "" : ",") << "\"" << w.name << "\":{\"count\":"
+            << w.operations << ",\"avg_us\":" << w.average
+            << ",\"min_us\":" << w.min << ",\"max_us\":" << w.max
+            << ",\"p50_us\":" << w.p50 << ",\"p99_us\":" << w.p99
+            << ",\"p999_us\":" << w.p999 << "}";
+      first = false;
+    }
+    file_ << "}";
+    if (!stats.empty()) {
+      file_ << ",\"stats\":{";
+      first = true;
+      for (const Stat &st : stats) {
+        file_ << (first ? "" : ",") << "\"" << st.metric << "."
+              << st.measurement << "\":" << st.value;
+        first = false;
+      }
+      file_ << "}";
+    }
+    file_ << "}" << std::endl;
+  } else {
+    for (const MeasurementWindow &w : windows) {
+      file_ << now_ms << "," << elapsed << "," << ops << "," << ops_per_sec
+            << "," << w.name << "," << w.operations << "," << w.average
+            << "," << w.min << "," << w.max << "," << w.p50 << ","
+            << w.p99 << "," << w.p999 << std::endl;
+    }
+    // A statistic takes the count column; it has no latencies.
+    for (const Stat &st : stats) {
+      file_ << now_ms << "," << elapsed << "," << ops << "," << ops_per_sec
+            << "," << st.metric << "." << st.measurement << "," << st.value
+            << ",,,,,," << std::endl;
+    }
+  }
+}
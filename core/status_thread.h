@@ -0,0 +1,109 @@
+//
+//  status_thread.h
+//  YCSB-C
+//
+
+#ifndef YCSB_C_STATUS_THREAD_H_
+#define YCSB_C_STATUS_THREAD_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/db.h"
+#include "core/measurements.h"
+#include "core/properties.h"
+
+namespace ycsbc {
+
+///
+/// Operations completed by one client thread, of which warmup_ops were
+/// started during the warm-up. Only that thread writes it; the padding
+/// keeps client threads off each other's cache lines.
+///
+struct ClientProgress {
+  std::atomic<uint64_t> ops_done{0};
+  std::atomic<uint64_t> warmup_ops{0};
+  char padding[64 - 2 * sizeof(std::atomic<uint64_t>)];
+};
+
+///
+/// Reports throughput and per-operation latencies of every interval of
+/// status.interval seconds to stderr while clients run, and optionally
+/// appends them to status.file as CSV rows or JSON lines. The statistics
+/// of the DB (see DB::ExportStats) are reported along with them.
+///
+class StatusThread {
+ public:
+  ///
+  /// The name of the property for the reporting interval in seconds.
+  /// Zero disables periodic status.
+  ///
+  static const std::string INTERVAL_PROPERTY;
+  static const std::string INTERVAL_DEFAULT;
+
+  ///
+  /// The name of the property for the file the intervals are written to.
+  ///
+  static const std::string FILE_PROPERTY;
+  static const std::string FILE_DEFAULT;
+
+  ///
+  /// The name of the property for the format of the status file.
+  /// Options are "csv" and "json".
+  ///
+  static const std::string FORMAT_PROPERTY;
+  static const std::string FORMAT_DEFAULT;
+
+  StatusThread(const utils::Properties &props,
+               const std::vector<ClientProgress> &progress, DB *db = NULL);
+  ~StatusThread() { Stop(); }
+
+  bool enabled() const { return interval_ms_ > 0; }
+
+  void Start();
+  ///
+  /// Reports the last, possibly partial, interval and joins the thread.
+  ///
+  void Stop();
+
+ private:
+  // A statistic of the DB, with its value formatted.
+  struct Stat {
+    std::string metric;
+    std::string measurement;
+    std::string value;
+  };
+  class StatsCollector;
+
+  void Run();
+  void Report();
+  void WriteFile(uint64_t now_ms, double elapsed, uint64_t ops,
+                 double ops_per_sec,
+                 const std::vector<MeasurementWindow> &windows,
+                 const std::vector<Stat> &stats);
+
+  const std::vector<ClientProgress> &progress_;
+  DB *db_;
+  uint64_t interval_ms_;
+  bool json_;
+  std::ofstream file_;
+
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_;
+
+  uint64_t start_ns_;
+  uint64_t last_ns_;
+  uint64_t last_ops_;
+};
+
+} // ycsbc
+
+#endif // YCSB_C_STATUS_THREAD_H_
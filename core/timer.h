@@ -10,6 +10,7 @@
 #define YCSB_C_TIMER_H_
 
 #include <chrono>
+#include <cstdint>
 
 namespace utils {
 
@@ -34,6 +35,15 @@ class Timer {
   Clock::time_point time_;
 };
 
+///
+/// Wall-clock time in nanoseconds since the epoch. This is the time base of
+/// the latencies recorded by DBWrapper and of intended start times.
+///
+inline uint64_t NowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
 } // utils
 
 #endif // YCSB_C_TIMER_H_
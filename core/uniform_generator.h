@@ -11,35 +11,29 @@
 
 #include "generator.h"
 
-#include <atomic>
-#include <mutex>
-#include <random>
+#include <cstdint>
+#include "utils.h"
 
 namespace ycsbc {
 
 class UniformGenerator : public Generator<uint64_t> {
  public:
   // Both min and max are inclusive
-  UniformGenerator(uint64_t min, uint64_t max) : dist_(min, max) { Next(); }
+  UniformGenerator(uint64_t min, uint64_t max) :
+      min_(min), range_(max - min + 1) { Next(); }
   
   uint64_t Next();
-  uint64_t Last();
+  uint64_t Last() { return last_int_; }
+  UniformGenerator *Clone() const { return new UniformGenerator(*this); }
   
  private:
-  std::mt19937_64 generator_;
-  std::uniform_int_distribution<uint64_t> dist_;
+  uint64_t min_;
+  uint64_t range_; /// Zero for the full 64-bit range
   uint64_t last_int_;
-  std::mutex mutex_;
 };
 
 inline uint64_t UniformGenerator::Next() {
-  std::lock_guard<std::mutex> lock(mutex_);
-  return last_int_ = dist_(generator_);
-}
-
-inline uint64_t UniformGenerator::Last() {
-  std::lock_guard<std::mutex> lock(mutex_);
-  return last_int_;
+  return last_int_ = min_ + utils::ThreadRandom().Uniform(range_);
 }
 
 } // ycsbc
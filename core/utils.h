@@ -12,7 +12,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <exception>
-#include <random>
+#include <string>
 
 namespace utils {
 
@@ -34,17 +34,91 @@ inline uint64_t FNVHash64(uint64_t val) {
 
 inline uint64_t Hash(uint64_t val) { return FNVHash64(val); }
 
+///
+/// Advances state by the golden-ratio increment and returns a well-mixed
+/// 64-bit value (splitmix64). Used to expand seeds.
+///
+inline uint64_t SplitMix64(uint64_t &state) {
+  uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+///
+/// xoshiro256** pseudorandom generator. It also meets the requirements of
+/// a uniform random bit generator, so it can drive <random> distributions.
+///
+class Random {
+ public:
+  typedef uint64_t result_type;
+
+  explicit Random(uint64_t seed = 0) { Seed(seed); }
+
+  void Seed(uint64_t seed) {
+    for (int i = 0; i < 4; i++)
+      s_[i] = SplitMix64(seed);
+  }
+
+  uint64_t Next() {
+    const uint64_t result = Rotl(s_[1] * 5, 7) * 9;
+    const uint64_t t = s_[1] << 17;
+    s_[2] ^= s_[0];
+    s_[3] ^= s_[1];
+    s_[1] ^= s_[2];
+    s_[0] ^= s_[3];
+    s_[2] ^= t;
+    s_[3] = Rotl(s_[3], 45);
+    return result;
+  }
+
+  /// Uniform in [0, n); n = 0 means the full 64-bit range.
+  uint64_t Uniform(uint64_t n) {
+    if (n == 0)
+      return Next();
+    return (uint64_t)(((unsigned __int128)Next() * n) >> 64);
+  }
+
+  /// Uniform in [0, 1).
+  double NextDouble() { return (Next() >> 11) * (1.0 / 9007199254740992.0); }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return UINT64_MAX; }
+  result_type operator()() { return Next(); }
+
+ private:
+  static uint64_t Rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+  uint64_t s_[4];
+};
+
+///
+/// The random generator of the calling thread, used by all generators and
+/// value builders.
+///
+inline Random &ThreadRandom() {
+  thread_local Random random;
+  return random;
+}
+
+///
+/// Seeds the calling thread's generator with its stream of the run-wide
+/// seed, so every thread draws an independent, reproducible sequence.
+///
+inline void SeedThreadRandom(uint64_t seed, uint64_t stream) {
+  uint64_t state = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+  ThreadRandom().Seed(SplitMix64(state));
+}
+
 inline double RandomDouble(double min = 0.0, double max = 1.0) {
-  static std::default_random_engine generator;
-  static std::uniform_real_distribution<double> uniform(min, max);
-  return uniform(generator);
+  return min + (max - min) * ThreadRandom().NextDouble();
 }
 
 ///
 /// Returns an ASCII code that can be printed to desplay
 ///
 inline char RandomPrintChar() {
-  return rand() % 94 + 33;
+  return ThreadRandom().Uniform(94) + 33;
 }
 
 // Big endian.
@@ -0,0 +1,80 @@
+//
+//  value_pool.h
+//  YCSB-C
+//
+
+#ifndef YCSB_C_VALUE_POOL_H_
+#define YCSB_C_VALUE_POOL_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "utils.h"
+
+namespace ycsbc {
+
+///
+/// A buffer of random printable bytes that field values are cut from, so
+/// building a value is a copy rather than a random draw per byte. Values
+/// are taken one after another; when the buffer is used up it starts over
+/// and, if refreshing, is refilled first so that no two values share bytes
+/// and the data stays as incompressible as per-byte random values.
+/// Not thread-safe: each client thread has its own pool.
+///
+class ValuePool {
+ public:
+  ValuePool() : size_(0), refresh_(true), pos_(0) { }
+
+  void Init(size_t size, bool refresh) {
+    size_ = size;
+    refresh_ = refresh;
+    buf_.clear();
+    pos_ = 0;
+  }
+
+  ///
+  /// Returns len random printable bytes, valid until the next call.
+  ///
+  const char *Take(size_t len) {
+    if (len > size_) // Longer than the pool; only for odd configs
+      size_ = len;
+    if (buf_.size() != size_) {
+      Fill();
+    } else if (pos_ + len > buf_.size()) {
+      pos_ = 0;
+      if (refresh_)
+        Fill();
+    }
+    const char *bytes = buf_.data() + pos_;
+    pos_ += len;
+    return bytes;
+  }
+
+  ///
+  /// Appends len random printable bytes to value.
+  ///
+  void Append(size_t len, std::string &value) {
+    value.append(Take(len), len);
+  }
+
+ private:
+  void Fill() {
+    buf_.resize(size_);
+    pos_ = 0;
+    utils::Random &random = utils::ThreadRandom();
+    for (size_t i = 0; i < size_; i += 8) {
+      uint64_t r = random.Next();
+      for (size_t j = i; j < i + 8 && j < size_; j++, r >>= 8)
+        buf_[j] = (char)(((r & 0xff) * 94 >> 8) + 33);
+    }
+  }
+
+  size_t size_;
+  bool refresh_;
+  std::vector<char> buf_;
+  size_t pos_;
+};
+
+} // ycsbc
+
+#endif // YCSB_C_VALUE_POOL_H_
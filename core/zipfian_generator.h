@@ -12,7 +12,7 @@
 #include <cassert>
 #include <cmath>
 #include <cstdint>
-#include <mutex>
+#include "generator.h"
 #include "utils.h"
 
 namespace ycsbc {
@@ -42,7 +42,9 @@ class ZipfianGenerator : public Generator<uint64_t> {
   
   uint64_t Next() { return Next(num_items_); }
 
-  uint64_t Last();
+  uint64_t Last() { return last_value_; }
+
+  ZipfianGenerator *Clone() const { return new ZipfianGenerator(*this); }
   
  private:
   ///
@@ -86,12 +88,10 @@ class ZipfianGenerator : public Generator<uint64_t> {
   double theta_, zeta_n_, eta_, alpha_, zeta_2_;
   uint64_t n_for_zeta_; /// Number of items used to compute zeta_n
   uint64_t last_value_;
-  std::mutex mutex_;
 };
 
 inline uint64_t ZipfianGenerator::Next(uint64_t num) {
   assert(num >= 2 && num < kMaxNumItems);
-  std::lock_guard<std::mutex> lock(mutex_);
 
   if (num > n_for_zeta_) { // Recompute zeta_n and eta
     RaiseZeta(num);
@@ -102,21 +102,16 @@ inline uint64_t ZipfianGenerator::Next(uint64_t num) {
   double uz = u * zeta_n_;
   
   if (uz < 1.0) {
-    return last_value_ = 0;
+    return last_value_ = base_;
   }
   
   if (uz < 1.0 + std::pow(0.5, theta_)) {
-    return last_value_ = 1;
+    return last_value_ = base_ + 1;
   }
 
   return last_value_ = base_ + num * std::pow(eta_ * u - eta_ + 1, alpha_);
 }
 
-inline uint64_t ZipfianGenerator::Last() {
-  std::lock_guard<std::mutex> lock(mutex_);
-  return last_value_;
-}
-
 }
 
 #endif // YCSB_C_ZIPFIAN_GENERATOR_H_
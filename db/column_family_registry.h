@@ -0,0 +1,87 @@
+//
+//  column_family_registry.h
+//  YCSB-C
+//
+
+#ifndef YCSB_C_COLUMN_FAMILY_REGISTRY_H_
+#define YCSB_C_COLUMN_FAMILY_REGISTRY_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rocksdb-cloud/include/rocksdb/db.h"
+
+namespace ycsbc {
+
+///
+/// Maps table names to column family handles. The map is copied on write
+/// and published with one atomic store, so Find() takes no lock, and each
+/// thread remembers the last table it looked up, so the common case is a
+/// pointer load and a comparison with that name. Column families are
+/// added rarely, hence every version of the map is kept until the
+/// registry is destroyed instead of tracking which readers still use one.
+///
+class ColumnFamilyRegistry {
+ public:
+  ColumnFamilyRegistry() : id_(NextId()) {
+    maps_.emplace_back(new Map);
+    map_.store(maps_.back().get(), std::memory_order_release);
+  }
+
+  ///
+  /// Returns the handle of table, or nullptr if it is not registered.
+  ///
+  rocksdb::ColumnFamilyHandle *Find(const std::string &table) const {
+    thread_local LastLookup last;
+    const Map *map = map_.load(std::memory_order_acquire);
+    if (last.registry == id_ && last.map == map && last.table == table)
+      return last.handle;
+    Map::const_iterator it = map->find(table);
+    if (it == map->end())
+      return nullptr;
+    last.registry = id_;
+    last.map = map;
+    last.table.assign(table);
+    last.handle = it->second;
+    return it->second;
+  }
+
+  ///
+  /// Registers handle as table. Callers serialize their Add()s.
+  ///
+  void Add(const std::string &table, rocksdb::ColumnFamilyHandle *handle) {
+    Map *map = new Map(*map_.load(std::memory_order_relaxed));
+    (*map)[table] = handle;
+    maps_.emplace_back(map);
+    map_.store(map, std::memory_order_release);
+  }
+
+ private:
+  typedef std::unordered_map<std::string, rocksdb::ColumnFamilyHandle*> Map;
+
+  struct LastLookup {
+    uint64_t registry = 0;
+    const Map *map = nullptr;
+    std::string table;
+    rocksdb::ColumnFamilyHandle *handle = nullptr;
+  };
+
+  // Tells registries apart in LastLookup, even one at the address of
+  // another that was destroyed.
+  static uint64_t NextId() {
+    static std::atomic<uint64_t> next_id(1);
+    return next_id.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  const uint64_t id_;
+  std::atomic<const Map*> map_;
+  std::vector<std::unique_ptr<Map>> maps_;
+};
+
+} // ycsbc
+
+#endif // YCSB_C_COLUMN_FAMILY_REGISTRY_H_
@@ -16,6 +16,9 @@
 #include "db/lock_stl_db.h"
 #include "db/rocksdb_db.h"
 #include "db/rocksdb_cloud_db.h"
+#include "db/rocksdb_options.h"
+#include "db/rocksdb_sharded_db.h"
+#include "db/rocksdb_txn_db.h"
 // #include "db/tbb_rand_db.h"
 // #include "db/tbb_scan_db.h"
 #include "rocksdb-cloud/include/rocksdb/cloud/cloud_env_options.h"
@@ -29,16 +32,25 @@ DB* DBFactory::CreateDB(utils::Properties &props) {
   p.SetProperty("measurement.histogram.verbose", "true");
   p.SetProperty("hdrhistogram.fileoutput", "true");
   p.SetProperty("hdrhistogram.output.path", "./");
+  // Measurement settings given on the command line or in the workload file
+  // (e.g. measurement.interval) override the defaults above.
+  for (auto& it : props.properties())
+    p.SetProperty(it.first, it.second);
   Measurements::set_properties(p);
   if (props["dbname"] == "basic") {
     return new BasicDB;
   } else if (props["dbname"] == "lock_stl") {
     return new LockStlDB;
   } else if (props["dbname"] == "rocksdb") {
-    rocksdb::Options options;
-    options.OptimizeLevelStyleCompaction();
-    options.create_if_missing = true;
-    return new DBWrapper(std::shared_ptr<DB>(new RocksdbDB(options, "/tmp/YCSB-C_rocksdb/")));
+    return new DBWrapper(std::shared_ptr<DB>(new RocksdbDB(RocksdbOptions(props))));
+  } else if (props["dbname"] == "rocksdb-sharded") {
+    return new DBWrapper(std::shared_ptr<DB>(new RocksdbShardedDB(RocksdbOptions(props))));
+  } else if (props["dbname"] == "rocksdb-txn") {
+    return new DBWrapper(std::shared_ptr<DB>(
+        new RocksdbTxnDB(RocksdbOptions(props), RocksdbTxnDB::kPessimistic)));
+  } else if (props["dbname"] == "rocksdb-occ") {
+    return new DBWrapper(std::shared_ptr<DB>(
+        new RocksdbTxnDB(RocksdbOptions(props), RocksdbTxnDB::kOptimistic)));
   } else if (props["dbname"] == "rocksdb-cloud") {
     std::string dbpath = "/tmp/YCSB-C_rocksdb-cloud";
     std::string region = "ap-northeast-1";
@@ -0,0 +1,45 @@
+//
+//  field_merge_operator.h
+//  YCSB-C
+//
+
+#ifndef YCSB_C_FIELD_MERGE_OPERATOR_H_
+#define YCSB_C_FIELD_MERGE_OPERATOR_H_
+
+#include <deque>
+#include <string>
+
+#include "db/record_codec.h"
+#include "rocksdb-cloud/include/rocksdb/merge_operator.h"
+
+namespace ycsbc {
+
+///
+/// Merges field patches into records. A merge operand is a record in the
+/// layout of db/record_codec.h holding only the updated fields; merging
+/// replaces the fields of the base record it names, later operands
+/// winning, and keeps the others. This lets an update be a blind Merge()
+/// instead of a Get() and a Put() of the whole record.
+///
+class FieldMergeOperator : public rocksdb::MergeOperator {
+ public:
+  /// Merged records are written in format.
+  explicit FieldMergeOperator(RecordFormat format) : format_(format) { }
+
+  bool FullMergeV2(const MergeOperationInput& merge_in,
+                   MergeOperationOutput* merge_out) const override;
+
+  bool PartialMergeMulti(const rocksdb::Slice& key,
+                         const std::deque<rocksdb::Slice>& operand_list,
+                         std::string* new_value,
+                         rocksdb::Logger* logger) const override;
+
+  const char* Name() const override { return "ycsbc.FieldMergeOperator"; }
+
+ private:
+  RecordFormat format_;
+};
+
+} // ycsbc
+
+#endif // YCSB_C_FIELD_MERGE_OPERATOR_H_
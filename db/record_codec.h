@@ -0,0 +1,226 @@
+//
+//  record_codec.h
+//  YCSB-C
+//
+
+#ifndef YCSB_C_RECORD_CODEC_H_
+#define YCSB_C_RECORD_CODEC_H_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "core/slice_db.h"
+#include "core/utils.h"
+
+namespace ycsbc {
+
+///
+/// The layouts RocksdbDB and RocksdbCloudDB store records in.
+///
+/// kLegacyRecord: for each field, a 4-byte big-endian length and the field
+/// name, then a 4-byte length and the value.
+///
+/// kCompactRecord: the byte kCompactRecordTag, the varint size of a header
+/// holding, for each field, the varint length of its name, the name and
+/// the varint length of its value; then all the values. A reader finds any
+/// value from the header alone, without going through the other values.
+///
+/// Legacy records start with the high byte of a name length, which is
+/// zero, so decoding tells the layouts apart and reads either one.
+///
+enum RecordFormat {
+  kLegacyRecord,
+  kCompactRecord
+};
+
+const char kCompactRecordTag = 2;
+
+inline size_t VarintLength(uint32_t v) {
+  size_t len = 1;
+  while (v >= 128) {
+    v >>= 7;
+    len++;
+  }
+  return len;
+}
+
+inline char *PutVarint32(char *dst, uint32_t v) {
+  while (v >= 128) {
+    *(dst++) = (char)(v | 128);
+    v >>= 7;
+  }
+  *(dst++) = (char)v;
+  return dst;
+}
+
+///
+/// Reads a varint at p, which is moved past it. Returns false if it does
+/// not end before limit.
+///
+inline bool GetVarint32(const char **p, const char *limit, uint32_t *v) {
+  uint32_t result = 0;
+  for (int shift = 0; shift <= 28 && *p < limit; shift += 7) {
+    uint32_t byte = (uint8_t)(**p);
+    (*p)++;
+    result |= (byte & 127) << shift;
+    if (byte < 128) {
+      *v = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+inline void EncodeField(const Slice &field, const Slice &value, std::string *record) {
+  char len[4];
+  utils::encode_int(len, field.size());
+  record->append(len, 4);
+  record->append(field.data(), field.size());
+  utils::encode_int(len, value.size());
+  record->append(len, 4);
+  record->append(value.data(), value.size());
+}
+
+///
+/// Appends a record of the field/value pairs of values to record. The pairs
+/// are anything convertible to Slice, e.g. SliceKVPair or DB::KVPair.
+///
+template <typename Pairs>
+void EncodeRecord(RecordFormat format, const Pairs &values, std::string *record) {
+  if (format == kLegacyRecord) {
+    for (const auto &p : values)
+      EncodeField(p.first, p.second, record);
+    return;
+  }
+  // Size it all first, then write it in one pass.
+  size_t header_size = 0;
+  size_t values_size = 0;
+  for (const auto &p : values) {
+    Slice field(p.first), value(p.second);
+    header_size += VarintLength(field.size()) + field.size() + VarintLength(value.size());
+    values_size += value.size();
+  }
+  size_t begin = record->size();
+  record->resize(begin + 1 + VarintLength(header_size) + header_size + values_size);
+  char *dst = &(*record)[begin];
+  *(dst++) = kCompactRecordTag;
+  dst = PutVarint32(dst, header_size);
+  for (const auto &p : values) {
+    Slice field(p.first), value(p.second);
+    dst = PutVarint32(dst, field.size());
+    memcpy(dst, field.data(), field.size());
+    dst += field.size();
+    dst = PutVarint32(dst, value.size());
+  }
+  for (const auto &p : values) {
+    Slice value(p.second);
+    memcpy(dst, value.data(), value.size());
+    dst += value.size();
+  }
+}
+
+///
+/// Whether field is selected by fields; NULL selects all of them.
+///
+template <typename Name>
+bool FieldSelected(const std::vector<Name> *fields, const Slice &field) {
+  if (fields == NULL)
+    return true;
+  for (const Name &f : *fields) {
+    if (Slice(f) == field)
+      return true;
+  }
+  return false;
+}
+
+///
+/// Calls visit(field, value) for the fields of the record selected by
+/// fields (NULL for all of them), with views into data. Compact records
+/// are only read where the selected values are. Returns false if the
+/// record is truncated.
+///
+template <typename Name, typename Visit>
+bool DecodeFields(const char *data, size_t size, const std::vector<Name> *fields,
+                  Visit visit) {
+  if (size > 0 && data[0] == kCompactRecordTag) {
+    const char *p = data + 1;
+    const char *limit = data + size;
+    uint32_t header_size;
+    if (!GetVarint32(&p, limit, &header_size) || header_size > (size_t)(limit - p))
+      return false;
+    const char *header_end = p + header_size;
+    const char *value = header_end;
+    while (p < header_end) {
+      uint32_t field_len, value_len;
+      if (!GetVarint32(&p, header_end, &field_len) || field_len > (size_t)(header_end - p))
+        return false;
+      Slice field(p, field_len);
+      p += field_len;
+      if (!GetVarint32(&p, header_end, &value_len) || value_len > (size_t)(limit - value))
+        return false;
+      if (FieldSelected(fields, field))
+        visit(field, Slice(value, value_len));
+      value += value_len;
+    }
+    return value == limit;
+  }
+
+  size_t off = 0;
+  while (off < size) {
+    if (off + 4 > size)
+      return false;
+    size_t field_len = utils::decode_int(data + off);
+    off += 4;
+    if (off + field_len + 4 > size)
+      return false;
+    Slice field(data + off, field_len);
+    off += field_len;
+    size_t value_len = utils::decode_int(data + off);
+    off += 4;
+    if (off + value_len > size)
+      return false;
+    if (FieldSelected(fields, field))
+      visit(field, Slice(data + off, value_len));
+    off += value_len;
+  }
+  return true;
+}
+
+///
+/// Calls visit(field, value) for every field of the record.
+///
+template <typename Visit>
+bool DecodeRecord(const char *data, size_t size, Visit visit) {
+  return DecodeFields(data, size, (const std::vector<Slice> *)NULL, visit);
+}
+
+///
+/// Appends to record the record old with the fields of values written
+/// over it: the fields of old that values does not have, then values.
+/// Returns false if old is truncated.
+///
+template <typename Pairs>
+bool PatchRecord(RecordFormat format, const char *old_data, size_t old_size,
+                 const Pairs &values, std::string *record) {
+  thread_local std::vector<SliceDB::SliceKVPair> fields;
+  fields.clear();
+  bool ok = DecodeRecord(old_data, old_size, [&](const Slice &f, const Slice &v) {
+    for (const auto &p : values) {
+      if (Slice(p.first) == f)
+        return;
+    }
+    fields.emplace_back(f, v);
+  });
+  if (!ok)
+    return false;
+  for (const auto &p : values)
+    fields.emplace_back(Slice(p.first), Slice(p.second));
+  EncodeRecord(format, fields, record);
+  return true;
+}
+
+} // ycsbc
+
+#endif // YCSB_C_RECORD_CODEC_H_
@@ -0,0 +1,35 @@
+//
+//  rocksdb_checkpoint.h
+//  YCSB-C
+//
+
+#ifndef YCSB_C_ROCKSDB_CHECKPOINT_H_
+#define YCSB_C_ROCKSDB_CHECKPOINT_H_
+
+#include <string>
+
+#include "rocksdb-cloud/include/rocksdb/db.h"
+#include "rocksdb-cloud/include/rocksdb/options.h"
+
+namespace ycsbc {
+
+///
+/// Flushes db and writes a checkpoint of it to dir, replacing the one
+/// there, if any. The SST files of the checkpoint are hard links to those
+/// of db when dir is on the same file system.
+///
+rocksdb::Status SaveCheckpoint(rocksdb::DB *db, const std::string &dir,
+                               const rocksdb::Options &options);
+
+///
+/// Replaces the DB in path, if any, with the one checkpointed in dir, to be
+/// opened next. SST files are never changed once written, so they are hard
+/// linked; the other files (CURRENT, MANIFEST, OPTIONS and logs) are
+/// copied, so the checkpoint stays as it is and can be restored again.
+///
+rocksdb::Status RestoreCheckpoint(const std::string &dir, const std::string &path,
+                                  const rocksdb::Options &options);
+
+} // ycsbc
+
+#endif // YCSB_C_ROCKSDB_CHECKPOINT_H_
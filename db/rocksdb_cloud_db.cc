@@ -1,87 +1,105 @@
 #include "core/utils.h"
 #include "db/rocksdb_cloud_db.h"
+#include "db/record_codec.h"
 
 namespace ycsbc {
 
 int RocksdbCloudDB::Read(const std::string &table, const std::string &key,
            const std::vector<std::string> *fields,
            std::vector<KVPair> &result) {
-  if (column_families_map_.count(table) == 0 && create_columnfamily(table) != 0)
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
     return DB::kError;
-  rocksdb::ColumnFamilyHandle* cfh;
-  {
-    ReadLock lock(&cf_lock_);
-    int idx = column_families_map_[table];
-    cfh = column_families_handles_[idx];
-  }
-  std::string value;
+  rocksdb::PinnableSlice value;
   rocksdb::Status s = rocksdb_->Get(rocksdb::ReadOptions(), cfh, rocksdb::Slice(key), &value);
   if (s.IsNotFound())
     return DB::kNotFound;
   else if (!s.ok())
     return DB::kError;
-  std::unordered_set<std::string> fields_set;
-  if (fields) {
-    for (const std::string& f : *fields)
-      fields_set.insert(f);
+  bool ok = DecodeFields(value.data(), value.size(), fields, [&](const Slice& f, const Slice& v) {
+    result.emplace_back(f.ToString(), v.ToString());
+  });
+  return ok ? DB::kOK : DB::kError;
+}
+
+int RocksdbCloudDB::MultiRead(const std::string &table, const std::vector<std::string> &keys,
+                         const std::vector<std::string> *fields,
+                         std::vector<std::vector<KVPair>> &results,
+                         std::vector<int> &statuses) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr) {
+    results.assign(keys.size(), std::vector<KVPair>());
+    statuses.assign(keys.size(), DB::kError);
+    return DB::kError;
   }
-  deserialize_values(value, &fields_set, &result);
-  return DB::kOK;
+  size_t n = keys.size();
+  std::vector<rocksdb::Slice> k(keys.begin(), keys.end());
+  std::unique_ptr<rocksdb::PinnableSlice[]> values(new rocksdb::PinnableSlice[n]);
+  std::vector<rocksdb::Status> s(n);
+  rocksdb_->MultiGet(rocksdb::ReadOptions(), cfh, n, k.data(), values.get(), s.data());
+
+  results.assign(n, std::vector<KVPair>());
+  statuses.resize(n);
+  int res = DB::kOK;
+  for (size_t i = 0; i < n; ++i) {
+    if (s[i].IsNotFound()) {
+      statuses[i] = DB::kNotFound;
+    } else if (!s[i].ok()) {
+      statuses[i] = DB::kError;
+    } else {
+      std::vector<KVPair> &r = results[i];
+      bool ok = DecodeFields(values[i].data(), values[i].size(), fields,
+                             [&r](const Slice& f, const Slice& v) {
+        r.emplace_back(f.ToString(), v.ToString());
+      });
+      statuses[i] = ok ? DB::kOK : DB::kError;
+    }
+    if (res == DB::kOK)
+      res = statuses[i];
+  }
+  return res;
 }
 
 int RocksdbCloudDB::Scan(const std::string &table, const std::string &key,
                     int len, const std::vector<std::string> *fields,
                     std::vector<std::vector<KVPair>> &result) {
-  if (column_families_map_.count(table) == 0 && create_columnfamily(table) != 0)
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
     return DB::kError;
-  rocksdb::ColumnFamilyHandle* cfh;
-  {
-    ReadLock lock(&cf_lock_);
-    int idx = column_families_map_[table];
-    cfh = column_families_handles_[idx];
-  }
-  rocksdb::Iterator* it = rocksdb_->NewIterator(rocksdb::ReadOptions(), cfh);
+  std::unique_ptr<rocksdb::Iterator> it(rocksdb_->NewIterator(rocksdb::ReadOptions(), cfh));
   int iterations = 0;
   it->Seek(key);
-  std::unordered_set<std::string> fields_set;
-  if (fields) {
-    for (const std::string& f : *fields)
-      fields_set.insert(f);
-  }
   while (it->Valid() && iterations < len) {
+    rocksdb::Slice value = it->value();
     std::vector<KVPair> r;
-    deserialize_values(std::string(it->value().data(), it->value().size()), &fields_set, &r);
+    if (!DecodeFields(value.data(), value.size(), fields, [&r](const Slice& f, const Slice& v) {
+          r.emplace_back(f.ToString(), v.ToString());
+        }))
+      return DB::kError;
     result.push_back(std::move(r));
     it->Next();
     iterations++;
   }
-  delete it;
-  return DB::kOK;
+  return it->status().ok() ? DB::kOK : DB::kError;
 }
 
 int RocksdbCloudDB::Update(const std::string &table, const std::string &key,
            std::vector<KVPair> &values) {
-  if (column_families_map_.count(table) == 0 && create_columnfamily(table) != 0)
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
     return DB::kError;
-  rocksdb::ColumnFamilyHandle* cfh;
-  {
-    ReadLock lock(&cf_lock_);
-    int idx = column_families_map_[table];
-    cfh = column_families_handles_[idx];
-  }
-  std::unordered_map<std::string, std::string> r;
-  std::string value;
-  rocksdb::Status s = rocksdb_->Get(rocksdb::ReadOptions(), cfh, key, &value);
+  thread_local std::string record;
+  record.clear();
+  rocksdb::PinnableSlice old_value;
+  rocksdb::Status s = rocksdb_->Get(rocksdb::ReadOptions(), cfh, key, &old_value);
   if (s.IsNotFound())
     return DB::kNotFound;
-  deserialize_values(value, nullptr, &r);
-
-  // update.
-  for (auto& p : values)
-    r[p.first] = p.second;
+  else if (!s.ok())
+    return DB::kError;
+  if (!PatchRecord(record_format_, old_value.data(), old_value.size(), values, &record))
+    return DB::kError;
 
-  // store.
-  s = rocksdb_->Put(rocksdb::WriteOptions(), cfh, key, serialize_values(r));
+  s = rocksdb_->Put(rocksdb::WriteOptions(), cfh, key, record);
   if (!s.ok())
     return DB::kError;
   return DB::kOK;
@@ -89,134 +107,193 @@ int RocksdbCloudDB::Update(const std::string &table, const std::string &key,
 
 int RocksdbCloudDB::Insert(const std::string &table, const std::string &key,
            std::vector<KVPair> &values) {
-  if (column_families_map_.count(table) == 0 && create_columnfamily(table) != 0)
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
     return DB::kError;
-  rocksdb::ColumnFamilyHandle* cfh;
-  {
-    ReadLock lock(&cf_lock_);
-    int idx = column_families_map_[table];
-    cfh = column_families_handles_[idx];
+  thread_local std::string record;
+  record.clear();
+  EncodeRecord(record_format_, values, &record);
+  rocksdb::Status s = rocksdb_->Put(rocksdb::WriteOptions(), cfh, key, record);
+  if (!s.ok())
+    return DB::kError;
+  return DB::kOK;
+}
+
+int RocksdbCloudDB::BatchInsert(const std::string &table, const std::vector<std::string> &keys,
+                           std::vector<std::vector<KVPair>> &values) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
+    return DB::kError;
+  thread_local rocksdb::WriteBatch batch;
+  thread_local std::string record;
+  batch.Clear();
+  for (size_t i = 0; i < keys.size(); ++i) {
+    record.clear();
+    EncodeRecord(record_format_, values[i], &record);
+    batch.Put(cfh, keys[i], record);
   }
-  rocksdb::Status s = rocksdb_->Put(rocksdb::WriteOptions(), cfh, key, serialize_values(values));
+  rocksdb::Status s = rocksdb_->Write(rocksdb::WriteOptions(), &batch);
   if (!s.ok())
     return DB::kError;
   return DB::kOK;
 }
 
 int RocksdbCloudDB::Delete(const std::string &table, const std::string &key) {
-  if (column_families_map_.count(table) == 0 && create_columnfamily(table) != 0)
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
     return DB::kError;
-  rocksdb::ColumnFamilyHandle* cfh;
-  {
-    ReadLock lock(&cf_lock_);
-    int idx = column_families_map_[table];
-    cfh = column_families_handles_[idx];
-  }
   rocksdb::Status s = rocksdb_->Delete(rocksdb::WriteOptions(), cfh, key);
   if (!s.ok())
     return DB::kError;
   return DB::kOK;
 }
 
-std::string RocksdbCloudDB::serialize_values(const std::unordered_map<std::string, std::string>& values) {
-  std::string str;
-  char temp[4];
-  for (auto& it : values) {
-    utils::encode_int(temp, it.first.size());
-    str.push_back(temp[0]);
-    str.push_back(temp[1]);
-    str.push_back(temp[2]);
-    str.push_back(temp[3]);
-    str.append(it.first);
-
-    utils::encode_int(temp, it.second.size());
-    str.push_back(temp[0]);
-    str.push_back(temp[1]);
-    str.push_back(temp[2]);
-    str.push_back(temp[3]);
-    str.append(it.second);
-  }
-  return str;
+int RocksdbCloudDB::Read(const std::string &table, const Slice &key,
+                    const std::vector<Slice> *fields, ResultBuffer &result) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
+    return DB::kError;
+  rocksdb::PinnableSlice value;
+  rocksdb::Status s = rocksdb_->Get(rocksdb::ReadOptions(), cfh,
+                                    rocksdb::Slice(key.data(), key.size()), &value);
+  if (s.IsNotFound())
+    return DB::kNotFound;
+  else if (!s.ok())
+    return DB::kError;
+  bool ok = DecodeFields(value.data(), value.size(), fields, [&](const Slice& f, const Slice& v) {
+    result.Append(f, v);
+  });
+  return ok ? DB::kOK : DB::kError;
 }
 
-std::string RocksdbCloudDB::serialize_values(const std::vector<KVPair>& values) {
-  std::string str;
-  char temp[4];
-  for (auto& it : values) {
-    utils::encode_int(temp, it.first.size());
-    str.push_back(temp[0]);
-    str.push_back(temp[1]);
-    str.push_back(temp[2]);
-    str.push_back(temp[3]);
-    str.append(it.first);
-
-    utils::encode_int(temp, it.second.size());
-    str.push_back(temp[0]);
-    str.push_back(temp[1]);
-    str.push_back(temp[2]);
-    str.push_back(temp[3]);
-    str.append(it.second);
+int RocksdbCloudDB::MultiRead(const std::string &table, const std::vector<Slice> &keys,
+                         const std::vector<Slice> *fields, ResultBuffer &result,
+                         std::vector<int> &statuses) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr) {
+    for (size_t i = 0; i < keys.size(); ++i)
+      result.EndRecord();
+    statuses.assign(keys.size(), DB::kError);
+    return DB::kError;
   }
-  return str;
-}
+  size_t n = keys.size();
+  thread_local std::vector<rocksdb::Slice> k;
+  thread_local std::vector<rocksdb::Status> s;
+  k.clear();
+  for (const Slice& key : keys)
+    k.emplace_back(key.data(), key.size());
+  s.assign(n, rocksdb::Status());
+  std::unique_ptr<rocksdb::PinnableSlice[]> values(new rocksdb::PinnableSlice[n]);
+  rocksdb_->MultiGet(rocksdb::ReadOptions(), cfh, n, k.data(), values.get(), s.data());
 
-void RocksdbCloudDB::deserialize_values(
-    const std::string& values,
-    const std::unordered_set<std::string>* fields,
-    std::unordered_map<std::string, std::string>* result) {
-  int off = 0;
-  while (off < (int)(values.size())) {
-    int key_len = utils::decode_int(values.c_str() + off);
-    off += 4;
-    std::string key = values.substr(off, key_len);
-    off += key_len;
-
-    int value_len = utils::decode_int(values.c_str() + off);
-    off += 4;
-    std::string value = values.substr(off, value_len);
-    off += value_len;
-
-    if (fields == nullptr || fields->count(key) > 0)
-      result->emplace(key, value);
+  statuses.resize(n);
+  int res = DB::kOK;
+  for (size_t i = 0; i < n; ++i) {
+    if (s[i].IsNotFound()) {
+      statuses[i] = DB::kNotFound;
+    } else if (!s[i].ok()) {
+      statuses[i] = DB::kError;
+    } else {
+      bool ok = DecodeFields(values[i].data(), values[i].size(), fields,
+                             [&](const Slice& f, const Slice& v) {
+        result.Append(f, v);
+      });
+      statuses[i] = ok ? DB::kOK : DB::kError;
+    }
+    result.EndRecord();
+    if (res == DB::kOK)
+      res = statuses[i];
   }
+  return res;
 }
 
-void RocksdbCloudDB::deserialize_values(
-        const std::string& values,
-        const std::unordered_set<std::string>* fields,
-        std::vector<KVPair>* result) {
-  int off = 0;
-  while (off < (int)(values.size())) {
-    int key_len = utils::decode_int(values.c_str() + off);
-    off += 4;
-    std::string key = values.substr(off, key_len);
-    off += key_len;
-
-    int value_len = utils::decode_int(values.c_str() + off);
-    off += 4;
-    std::string value = values.substr(off, value_len);
-    off += value_len;
-
-    if (fields == nullptr || fields->count(key) > 0)
-      result->emplace_back(key, value);
+int RocksdbCloudDB::Scan(const std::string &table, const Slice &key,
+                    int len, const std::vector<Slice> *fields, ResultBuffer &result) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
+    return DB::kError;
+  std::unique_ptr<rocksdb::Iterator> it(rocksdb_->NewIterator(rocksdb::ReadOptions(), cfh));
+  int iterations = 0;
+  it->Seek(rocksdb::Slice(key.data(), key.size()));
+  while (it->Valid() && iterations < len) {
+    rocksdb::Slice value = it->value();
+    if (!DecodeFields(value.data(), value.size(), fields, [&](const Slice& f, const Slice& v) {
+          result.Append(f, v);
+        }))
+      return DB::kError;
+    result.EndRecord();
+    it->Next();
+    iterations++;
   }
+  return it->status().ok() ? DB::kOK : DB::kError;
+}
+
+int RocksdbCloudDB::Update(const std::string &table, const Slice &key,
+                      const std::vector<SliceKVPair> &values) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
+    return DB::kError;
+  rocksdb::Slice k(key.data(), key.size());
+  rocksdb::PinnableSlice old_value;
+  rocksdb::Status s = rocksdb_->Get(rocksdb::ReadOptions(), cfh, k, &old_value);
+  if (s.IsNotFound())
+    return DB::kNotFound;
+  else if (!s.ok())
+    return DB::kError;
+
+  thread_local std::string record;
+  record.clear();
+  if (!PatchRecord(record_format_, old_value.data(), old_value.size(), values, &record))
+    return DB::kError;
+
+  s = rocksdb_->Put(rocksdb::WriteOptions(), cfh, k, record);
+  if (!s.ok())
+    return DB::kError;
+  return DB::kOK;
+}
+
+int RocksdbCloudDB::Insert(const std::string &table, const Slice &key,
+                      const std::vector<SliceKVPair> &values) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
+    return DB::kError;
+  thread_local std::string record;
+  record.clear();
+  EncodeRecord(record_format_, values, &record);
+  rocksdb::Status s = rocksdb_->Put(rocksdb::WriteOptions(), cfh,
+                                    rocksdb::Slice(key.data(), key.size()), record);
+  if (!s.ok())
+    return DB::kError;
+  return DB::kOK;
+}
+
+int RocksdbCloudDB::Delete(const std::string &table, const Slice &key) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
+    return DB::kError;
+  rocksdb::Status s = rocksdb_->Delete(rocksdb::WriteOptions(), cfh,
+                                       rocksdb::Slice(key.data(), key.size()));
+  if (!s.ok())
+    return DB::kError;
+  return DB::kOK;
+}
+
+rocksdb::ColumnFamilyHandle* RocksdbCloudDB::get_columnfamily(const std::string& table) {
+  rocksdb::ColumnFamilyHandle* cfh = column_families_.Find(table);
+  if (cfh == nullptr && create_columnfamily(table) == 0)
+    cfh = column_families_.Find(table);
+  return cfh;
 }
 
 int RocksdbCloudDB::create_columnfamily(const std::string& name) {
-  WriteLock lock(&cf_lock_);
-  if (column_families_map_.count(name) == 0) {
-    rocksdb::ColumnFamilyOptions cfo;
-    cfo.OptimizeLevelStyleCompaction();
+  MutexLock lock(&cf_lock_);
+  if (column_families_.Find(name) == nullptr) {
     rocksdb::ColumnFamilyHandle* cfh;
-    rocksdb::Status s = rocksdb_->CreateColumnFamily(cfo, name, &cfh);
-    rocksdb::ColumnFamilyDescriptor cfd;
-    if (s.ok() && cfh->GetDescriptor(&cfd).ok()) {
-      column_families_map_.emplace(name, column_families_.size());
-      column_families_.push_back(cfd);
-      column_families_handles_.push_back(cfh);
-    }
-    else
+    rocksdb::Status s = rocksdb_->CreateColumnFamily(cf_options_, name, &cfh);
+    if (!s.ok())
       return -1;
+    column_families_handles_.push_back(cfh);
+    column_families_.Add(name, cfh);
   }
   return 0;
 }
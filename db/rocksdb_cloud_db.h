@@ -12,20 +12,22 @@
 #include <iostream>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #include "core/properties.h"
+#include "db/column_family_registry.h"
+#include "db/record_codec.h"
 #include "rocksdb-cloud/include/rocksdb/cloud/db_cloud.h"
 #include "rocksdb-cloud/include/rocksdb/db.h"
 #include "rocksdb-cloud/include/rocksdb/options.h"
+#include "rocksdb-cloud/include/rocksdb/write_batch.h"
 
 using std::cout;
 using std::endl;
 
 namespace ycsbc {
 
-class RocksdbCloudDB : public DB {
+class RocksdbCloudDB : public DB, public SliceDB {
  public:
   RocksdbCloudDB(const rocksdb::Options& db_options, const std::string& dbpath, std::unique_ptr<rocksdb::CloudEnv>&& env): env_(std::move(env)) {
     rocksdb::Status s = rocksdb::DBCloud::Open(db_options, dbpath, "", 0, &rocksdb_);
@@ -33,9 +35,9 @@ class RocksdbCloudDB : public DB {
       printf("cannot open rocksdb: %s\n", s.ToString().c_str());
       exit(-1);
     }
-    column_families_map_.emplace("default", 0);
+    cf_options_ = rocksdb::ColumnFamilyOptions(db_options);
     column_families_handles_.push_back(rocksdb_->DefaultColumnFamily());
-    column_families_.push_back(rocksdb::ColumnFamilyDescriptor("default", rocksdb::ColumnFamilyOptions()));
+    column_families_.Add(rocksdb::kDefaultColumnFamilyName, rocksdb_->DefaultColumnFamily());
   }
   RocksdbCloudDB(const rocksdb::Options& db_options, const std::string& dbpath,
             const std::vector<rocksdb::ColumnFamilyDescriptor>& column_families,
@@ -45,9 +47,12 @@ class RocksdbCloudDB : public DB {
       printf("cannot open rocksdb: %s\n", s.ToString().c_str());
       exit(-1);
     }
+    // Column families created later on get the options of the default one.
+    cf_options_ = rocksdb::ColumnFamilyOptions(db_options);
     for (int i = 0; i < (int)(column_families.size()); i++) {
-      column_families_map_.emplace(column_families[i].name, i);
-      column_families_.push_back(column_families[i]);
+      column_families_.Add(column_families[i].name, column_families_handles_[i]);
+      if (column_families[i].name == rocksdb::kDefaultColumnFamilyName)
+        cf_options_ = column_families[i].options;
     }
   }
 
@@ -59,6 +64,12 @@ class RocksdbCloudDB : public DB {
            const std::vector<std::string> *fields,
            std::vector<KVPair> &result);
 
+  /// Looks the keys up with one batched MultiGet.
+  int MultiRead(const std::string &table, const std::vector<std::string> &keys,
+                const std::vector<std::string> *fields,
+                std::vector<std::vector<KVPair>> &results,
+                std::vector<int> &statuses);
+
   int Scan(const std::string &table, const std::string &key,
            int len, const std::vector<std::string> *fields,
            std::vector<std::vector<KVPair>> &result);
@@ -69,27 +80,43 @@ class RocksdbCloudDB : public DB {
   int Insert(const std::string &table, const std::string &key,
              std::vector<KVPair> &values);
 
+  /// Writes the records with one WriteBatch.
+  int BatchInsert(const std::string &table, const std::vector<std::string> &keys,
+                  std::vector<std::vector<KVPair>> &values);
+
   int Delete(const std::string &table, const std::string &key);
 
+  SliceDB *GetSliceDB() { return this; }
+
+  int Read(const std::string &table, const Slice &key,
+           const std::vector<Slice> *fields, ResultBuffer &result);
+
+  int MultiRead(const std::string &table, const std::vector<Slice> &keys,
+                const std::vector<Slice> *fields, ResultBuffer &result,
+                std::vector<int> &statuses);
+
+  int Scan(const std::string &table, const Slice &key,
+           int len, const std::vector<Slice> *fields, ResultBuffer &result);
+
+  int Update(const std::string &table, const Slice &key,
+             const std::vector<SliceKVPair> &values);
+
+  int Insert(const std::string &table, const Slice &key,
+             const std::vector<SliceKVPair> &values);
+
+  int Delete(const std::string &table, const Slice &key);
+
  private:
   std::unique_ptr<rocksdb::CloudEnv> env_;
   rocksdb::DBCloud* rocksdb_;
-  std::unordered_map<std::string, int> column_families_map_;
-  std::vector<rocksdb::ColumnFamilyDescriptor> column_families_;
+  ColumnFamilyRegistry column_families_;
+  RecordFormat record_format_ = kLegacyRecord;
   std::vector<rocksdb::ColumnFamilyHandle*> column_families_handles_;
-  RWMutex cf_lock_;
-
-  std::string serialize_values(const std::unordered_map<std::string, std::string>& values);
-  std::string serialize_values(const std::vector<KVPair>& values);
-  void deserialize_values(
-        const std::string& values,
-        const std::unordered_set<std::string>* fields,
-        std::unordered_map<std::string, std::string>* result);
-  void deserialize_values(
-        const std::string& values,
-        const std::unordered_set<std::string>* fields,
-        std::vector<KVPair>* result);
+  rocksdb::ColumnFamilyOptions cf_options_;
+  Mutex cf_lock_; // Serializes create_columnfamily()
+
   int create_columnfamily(const std::string& name);
+  rocksdb::ColumnFamilyHandle* get_columnfamily(const std::string& table);
 };
 
 } // ycsbc
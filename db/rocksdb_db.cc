@@ -1,87 +1,118 @@
+#include "core/timer.h"
 #include "core/utils.h"
 #include "db/rocksdb_db.h"
+#include "db/record_codec.h"
+#include "db/rocksdb_checkpoint.h"
 
 namespace ycsbc {
 
 int RocksdbDB::Read(const std::string &table, const std::string &key,
            const std::vector<std::string> *fields,
            std::vector<KVPair> &result) {
-  if (column_families_map_.count(table) == 0 && create_columnfamily(table) != 0)
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
     return DB::kError;
-  rocksdb::ColumnFamilyHandle* cfh;
-  {
-    ReadLock lock(&cf_lock_);
-    int idx = column_families_map_[table];
-    cfh = column_families_handles_[idx];
-  }
-  std::string value;
+  RocksdbStats::Sample sample(stats_.get(), RocksdbStats::kRead);
+  rocksdb::PinnableSlice value;
   rocksdb::Status s = rocksdb_->Get(rocksdb::ReadOptions(), cfh, rocksdb::Slice(key), &value);
   if (s.IsNotFound())
     return DB::kNotFound;
   else if (!s.ok())
     return DB::kError;
-  std::unordered_set<std::string> fields_set;
-  if (fields) {
-    for (const std::string& f : *fields)
-      fields_set.insert(f);
+  bool ok = DecodeFields(value.data(), value.size(), fields, [&](const Slice& f, const Slice& v) {
+    result.emplace_back(f.ToString(), v.ToString());
+  });
+  return ok ? DB::kOK : DB::kError;
+}
+
+int RocksdbDB::MultiRead(const std::string &table, const std::vector<std::string> &keys,
+                         const std::vector<std::string> *fields,
+                         std::vector<std::vector<KVPair>> &results,
+                         std::vector<int> &statuses) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr) {
+    results.assign(keys.size(), std::vector<KVPair>());
+    statuses.assign(keys.size(), DB::kError);
+    return DB::kError;
   }
-  deserialize_values(value, &fields_set, &result);
-  return DB::kOK;
+  RocksdbStats::Sample sample(stats_.get(), RocksdbStats::kRead, keys.size());
+  size_t n = keys.size();
+  std::vector<rocksdb::Slice> k(keys.begin(), keys.end());
+  std::unique_ptr<rocksdb::PinnableSlice[]> values(new rocksdb::PinnableSlice[n]);
+  std::vector<rocksdb::Status> s(n);
+  multi_get(cfh, n, k.data(), values.get(), s.data());
+
+  results.assign(n, std::vector<KVPair>());
+  statuses.resize(n);
+  int res = DB::kOK;
+  for (size_t i = 0; i < n; ++i) {
+    if (s[i].IsNotFound()) {
+      statuses[i] = DB::kNotFound;
+    } else if (!s[i].ok()) {
+      statuses[i] = DB::kError;
+    } else {
+      std::vector<KVPair> &r = results[i];
+      bool ok = DecodeFields(values[i].data(), values[i].size(), fields,
+                             [&r](const Slice& f, const Slice& v) {
+        r.emplace_back(f.ToString(), v.ToString());
+      });
+      statuses[i] = ok ? DB::kOK : DB::kError;
+    }
+    if (res == DB::kOK)
+      res = statuses[i];
+  }
+  return res;
 }
 
 int RocksdbDB::Scan(const std::string &table, const std::string &key,
                     int len, const std::vector<std::string> *fields,
                     std::vector<std::vector<KVPair>> &result) {
-  if (column_families_map_.count(table) == 0 && create_columnfamily(table) != 0)
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
     return DB::kError;
-  rocksdb::ColumnFamilyHandle* cfh;
-  {
-    ReadLock lock(&cf_lock_);
-    int idx = column_families_map_[table];
-    cfh = column_families_handles_[idx];
-  }
-  rocksdb::Iterator* it = rocksdb_->NewIterator(rocksdb::ReadOptions(), cfh);
+  RocksdbStats::Sample sample(stats_.get(), RocksdbStats::kScan);
+  std::unique_ptr<rocksdb::Iterator> owned;
+  rocksdb::Iterator* it = scan_iterator(cfh, &owned);
   int iterations = 0;
   it->Seek(key);
-  std::unordered_set<std::string> fields_set;
-  if (fields) {
-    for (const std::string& f : *fields)
-      fields_set.insert(f);
-  }
   while (it->Valid() && iterations < len) {
+    rocksdb::Slice value = it->value();
     std::vector<KVPair> r;
-    deserialize_values(std::string(it->value().data(), it->value().size()), &fields_set, &r);
+    if (!DecodeFields(value.data(), value.size(), fields, [&r](const Slice& f, const Slice& v) {
+          r.emplace_back(f.ToString(), v.ToString());
+        }))
+      return DB::kError;
     result.push_back(std::move(r));
     it->Next();
     iterations++;
   }
-  delete it;
-  return DB::kOK;
+  return it->status().ok() ? DB::kOK : DB::kError;
 }
 
 int RocksdbDB::Update(const std::string &table, const std::string &key,
            std::vector<KVPair> &values) {
-  if (column_families_map_.count(table) == 0 && create_columnfamily(table) != 0)
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
     return DB::kError;
-  rocksdb::ColumnFamilyHandle* cfh;
-  {
-    ReadLock lock(&cf_lock_);
-    int idx = column_families_map_[table];
-    cfh = column_families_handles_[idx];
+  RocksdbStats::Sample sample(stats_.get(), RocksdbStats::kWrite);
+  thread_local std::string record;
+  record.clear();
+  if (merge_updates_) {
+    EncodeRecord(record_format_, values, &record);
+    rocksdb::Status s = rocksdb_->Merge(write_options_, cfh, key, record);
+    return s.ok() ? DB::kOK : DB::kError;
   }
-  std::unordered_map<std::string, std::string> r;
-  std::string value;
-  rocksdb::Status s = rocksdb_->Get(rocksdb::ReadOptions(), cfh, key, &value);
+
+  rocksdb::PinnableSlice old_value;
+  rocksdb::Status s = rocksdb_->Get(rocksdb::ReadOptions(), cfh, key, &old_value);
   if (s.IsNotFound())
     return DB::kNotFound;
-  deserialize_values(value, nullptr, &r);
-
-  // update.
-  for (auto& p : values)
-    r[p.first] = p.second;
+  else if (!s.ok())
+    return DB::kError;
+  if (!PatchRecord(record_format_, old_value.data(), old_value.size(), values, &record))
+    return DB::kError;
 
-  // store.
-  s = rocksdb_->Put(rocksdb::WriteOptions(), cfh, key, serialize_values(r));
+  s = rocksdb_->Put(write_options_, cfh, key, record);
   if (!s.ok())
     return DB::kError;
   return DB::kOK;
@@ -89,134 +120,486 @@ int RocksdbDB::Update(const std::string &table, const std::string &key,
 
 int RocksdbDB::Insert(const std::string &table, const std::string &key,
            std::vector<KVPair> &values) {
-  if (column_families_map_.count(table) == 0 && create_columnfamily(table) != 0)
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
     return DB::kError;
-  rocksdb::ColumnFamilyHandle* cfh;
-  {
-    ReadLock lock(&cf_lock_);
-    int idx = column_families_map_[table];
-    cfh = column_families_handles_[idx];
+  RocksdbStats::Sample sample(stats_.get(), RocksdbStats::kWrite);
+  thread_local std::string record;
+  record.clear();
+  EncodeRecord(record_format_, values, &record);
+  rocksdb::Status s = rocksdb_->Put(write_options_, cfh, key, record);
+  if (!s.ok())
+    return DB::kError;
+  return DB::kOK;
+}
+
+int RocksdbDB::BatchInsert(const std::string &table, const std::vector<std::string> &keys,
+                           std::vector<std::vector<KVPair>> &values) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
+    return DB::kError;
+  RocksdbStats::Sample sample(stats_.get(), RocksdbStats::kWrite, keys.size());
+  thread_local rocksdb::WriteBatch batch;
+  thread_local std::string record;
+  batch.Clear();
+  for (size_t i = 0; i < keys.size(); ++i) {
+    record.clear();
+    EncodeRecord(record_format_, values[i], &record);
+    batch.Put(cfh, keys[i], record);
   }
-  rocksdb::Status s = rocksdb_->Put(rocksdb::WriteOptions(), cfh, key, serialize_values(values));
+  rocksdb::Status s = rocksdb_->Write(write_options_, &batch);
   if (!s.ok())
     return DB::kError;
   return DB::kOK;
 }
 
 int RocksdbDB::Delete(const std::string &table, const std::string &key) {
-  if (column_families_map_.count(table) == 0 && create_columnfamily(table) != 0)
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
     return DB::kError;
-  rocksdb::ColumnFamilyHandle* cfh;
-  {
-    ReadLock lock(&cf_lock_);
-    int idx = column_families_map_[table];
-    cfh = column_families_handles_[idx];
+  RocksdbStats::Sample sample(stats_.get(), RocksdbStats::kWrite);
+  rocksdb::Status s = rocksdb_->Delete(write_options_, cfh, key);
+  if (!s.ok())
+    return DB::kError;
+  return DB::kOK;
+}
+
+int RocksdbDB::Read(const std::string &table, const Slice &key,
+                    const std::vector<Slice> *fields, ResultBuffer &result) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
+    return DB::kError;
+  RocksdbStats::Sample sample(stats_.get(), RocksdbStats::kRead);
+  rocksdb::PinnableSlice value;
+  rocksdb::Status s = rocksdb_->Get(rocksdb::ReadOptions(), cfh,
+                                    rocksdb::Slice(key.data(), key.size()), &value);
+  if (s.IsNotFound())
+    return DB::kNotFound;
+  else if (!s.ok())
+    return DB::kError;
+  bool ok = DecodeFields(value.data(), value.size(), fields, [&](const Slice& f, const Slice& v) {
+    result.Append(f, v);
+  });
+  return ok ? DB::kOK : DB::kError;
+}
+
+int RocksdbDB::MultiRead(const std::string &table, const std::vector<Slice> &keys,
+                         const std::vector<Slice> *fields, ResultBuffer &result,
+                         std::vector<int> &statuses) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr) {
+    for (size_t i = 0; i < keys.size(); ++i)
+      result.EndRecord();
+    statuses.assign(keys.size(), DB::kError);
+    return DB::kError;
+  }
+  RocksdbStats::Sample sample(stats_.get(), RocksdbStats::kRead, keys.size());
+  size_t n = keys.size();
+  thread_local std::vector<rocksdb::Slice> k;
+  thread_local std::vector<rocksdb::Status> s;
+  k.clear();
+  for (const Slice& key : keys)
+    k.emplace_back(key.data(), key.size());
+  s.assign(n, rocksdb::Status());
+  std::unique_ptr<rocksdb::PinnableSlice[]> values(new rocksdb::PinnableSlice[n]);
+  multi_get(cfh, n, k.data(), values.get(), s.data());
+
+  statuses.resize(n);
+  int res = DB::kOK;
+  for (size_t i = 0; i < n; ++i) {
+    if (s[i].IsNotFound()) {
+      statuses[i] = DB::kNotFound;
+    } else if (!s[i].ok()) {
+      statuses[i] = DB::kError;
+    } else {
+      bool ok = DecodeFields(values[i].data(), values[i].size(), fields,
+                             [&](const Slice& f, const Slice& v) {
+        result.Append(f, v);
+      });
+      statuses[i] = ok ? DB::kOK : DB::kError;
+    }
+    result.EndRecord();
+    if (res == DB::kOK)
+      res = statuses[i];
+  }
+  return res;
+}
+
+int RocksdbDB::Scan(const std::string &table, const Slice &key,
+                    int len, const std::vector<Slice> *fields, ResultBuffer &result) {
+  return StreamScan(table, key, len, fields, result);
+}
+
+int RocksdbDB::StreamScan(const std::string &table, const Slice &key,
+                          int len, const std::vector<Slice> *fields, ScanVisitor &visitor) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
+    return DB::kError;
+  RocksdbStats::Sample sample(stats_.get(), RocksdbStats::kScan);
+  std::unique_ptr<rocksdb::Iterator> owned;
+  rocksdb::Iterator* it = scan_iterator(cfh, &owned);
+  int iterations = 0;
+  it->Seek(rocksdb::Slice(key.data(), key.size()));
+  while (it->Valid() && iterations < len) {
+    rocksdb::Slice value = it->value();
+    if (!DecodeFields(value.data(), value.size(), fields, [&](const Slice& f, const Slice& v) {
+          visitor.Field(f, v);
+        }))
+      return DB::kError;
+    visitor.EndRecord();
+    it->Next();
+    iterations++;
+  }
+  return it->status().ok() ? DB::kOK : DB::kError;
+}
+
+int RocksdbDB::Update(const std::string &table, const Slice &key,
+                      const std::vector<SliceKVPair> &values) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
+    return DB::kError;
+  RocksdbStats::Sample sample(stats_.get(), RocksdbStats::kWrite);
+  rocksdb::Slice k(key.data(), key.size());
+  thread_local std::string record;
+  record.clear();
+  if (merge_updates_) {
+    EncodeRecord(record_format_, values, &record);
+    rocksdb::Status s = rocksdb_->Merge(write_options_, cfh, k, record);
+    return s.ok() ? DB::kOK : DB::kError;
   }
-  rocksdb::Status s = rocksdb_->Delete(rocksdb::WriteOptions(), cfh, key);
+
+  rocksdb::PinnableSlice old_value;
+  rocksdb::Status s = rocksdb_->Get(rocksdb::ReadOptions(), cfh, k, &old_value);
+  if (s.IsNotFound())
+    return DB::kNotFound;
+  else if (!s.ok())
+    return DB::kError;
+
+  if (!PatchRecord(record_format_, old_value.data(), old_value.size(), values, &record))
+    return DB::kError;
+
+  s = rocksdb_->Put(write_options_, cfh, k, record);
+  if (!s.ok())
+    return DB::kError;
+  return DB::kOK;
+}
+
+int RocksdbDB::Insert(const std::string &table, const Slice &key,
+                      const std::vector<SliceKVPair> &values) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
+    return DB::kError;
+  RocksdbStats::Sample sample(stats_.get(), RocksdbStats::kWrite);
+  thread_local std::string record;
+  record.clear();
+  EncodeRecord(record_format_, values, &record);
+  rocksdb::Status s = rocksdb_->Put(write_options_, cfh,
+                                    rocksdb::Slice(key.data(), key.size()), record);
   if (!s.ok())
     return DB::kError;
   return DB::kOK;
 }
 
-std::string RocksdbDB::serialize_values(const std::unordered_map<std::string, std::string>& values) {
-  std::string str;
-  char temp[4];
-  for (auto& it : values) {
-    utils::encode_int(temp, it.first.size());
-    str.push_back(temp[0]);
-    str.push_back(temp[1]);
-    str.push_back(temp[2]);
-    str.push_back(temp[3]);
-    str.append(it.first);
-
-    utils::encode_int(temp, it.second.size());
-    str.push_back(temp[0]);
-    str.push_back(temp[1]);
-    str.push_back(temp[2]);
-    str.push_back(temp[3]);
-    str.append(it.second);
-  }
-  return str;
-}
-
-std::string RocksdbDB::serialize_values(const std::vector<KVPair>& values) {
-  std::string str;
-  char temp[4];
-  for (auto& it : values) {
-    utils::encode_int(temp, it.first.size());
-    str.push_back(temp[0]);
-    str.push_back(temp[1]);
-    str.push_back(temp[2]);
-    str.push_back(temp[3]);
-    str.append(it.first);
-
-    utils::encode_int(temp, it.second.size());
-    str.push_back(temp[0]);
-    str.push_back(temp[1]);
-    str.push_back(temp[2]);
-    str.push_back(temp[3]);
-    str.append(it.second);
-  }
-  return str;
-}
-
-void RocksdbDB::deserialize_values(
-    const std::string& values,
-    const std::unordered_set<std::string>* fields,
-    std::unordered_map<std::string, std::string>* result) {
-  int off = 0;
-  while (off < (int)(values.size())) {
-    int key_len = utils::decode_int(values.c_str() + off);
-    off += 4;
-    std::string key = values.substr(off, key_len);
-    off += key_len;
-
-    int value_len = utils::decode_int(values.c_str() + off);
-    off += 4;
-    std::string value = values.substr(off, value_len);
-    off += value_len;
-
-    if (fields == nullptr || fields->count(key) > 0)
-      result->emplace(key, value);
-  }
-}
-
-void RocksdbDB::deserialize_values(
-        const std::string& values,
-        const std::unordered_set<std::string>* fields,
-        std::vector<KVPair>* result) {
-  int off = 0;
-  while (off < (int)(values.size())) {
-    int key_len = utils::decode_int(values.c_str() + off);
-    off += 4;
-    std::string key = values.substr(off, key_len);
-    off += key_len;
-
-    int value_len = utils::decode_int(values.c_str() + off);
-    off += 4;
-    std::string value = values.substr(off, value_len);
-    off += value_len;
-
-    if (fields == nullptr || fields->count(key) > 0)
-      result->emplace_back(key, value);
+int RocksdbDB::Delete(const std::string &table, const Slice &key) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
+    return DB::kError;
+  RocksdbStats::Sample sample(stats_.get(), RocksdbStats::kWrite);
+  rocksdb::Status s = rocksdb_->Delete(write_options_, cfh,
+                                       rocksdb::Slice(key.data(), key.size()));
+  if (!s.ok())
+    return DB::kError;
+  return DB::kOK;
+}
+
+class RocksdbDB::SstRecordWriter : public RecordFileWriter {
+ public:
+  SstRecordWriter(RocksdbDB *db, const std::string &table,
+                  rocksdb::ColumnFamilyHandle *cfh, const std::string &path) :
+      db_(db), table_(table), path_(path), num_records_(0),
+      writer_(rocksdb::EnvOptions(),
+              db->rocksdb_->GetOptions(cfh ? cfh : db->rocksdb_->DefaultColumnFamily()), cfh) {
+    if (cfh == nullptr)
+      status_ = rocksdb::Status::InvalidArgument("cannot create column family " + table);
+    else
+      status_ = writer_.Open(path_);
+    if (!status_.ok())
+      printf("cannot open %s: %s\n", path_.c_str(), status_.ToString().c_str());
+  }
+
+  int Add(const Slice &key, const std::vector<SliceKVPair> &values) {
+    if (!status_.ok())
+      return DB::kError;
+    record_.clear();
+    EncodeRecord(db_->record_format_, values, &record_);
+    rocksdb::Status s = writer_.Put(rocksdb::Slice(key.data(), key.size()), record_);
+    if (!s.ok())
+      return DB::kError;
+    num_records_++;
+    return DB::kOK;
+  }
+
+  int Finish() {
+    // RocksDB refuses to finish an empty file.
+    if (!status_.ok() || num_records_ == 0)
+      return status_.ok() ? DB::kOK : DB::kError;
+    rocksdb::Status s = writer_.Finish();
+    if (!s.ok()) {
+      printf("cannot finish %s: %s\n", path_.c_str(), s.ToString().c_str());
+      return DB::kError;
+    }
+    MutexLock lock(&db_->ingest_lock_);
+    db_->ingest_files_[table_].push_back(path_);
+    return DB::kOK;
+  }
+
+ private:
+  RocksdbDB *db_;
+  std::string table_;
+  std::string path_;
+  size_t num_records_;
+  rocksdb::SstFileWriter writer_;
+  rocksdb::Status status_;
+  std::string record_;
+};
+
+RecordFileWriter *RocksdbDB::NewFileWriter(const std::string &table) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  int n;
+  {
+    MutexLock lock(&ingest_lock_);
+    n = num_ingest_files_++;
+  }
+  std::string path = rocksdb_->GetName() + "/ycsbc-ingest-" + std::to_string(n) + ".sst";
+  return new SstRecordWriter(this, table, cfh, path);
+}
+
+int RocksdbDB::IngestFiles(const std::string &table) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
+    return DB::kError;
+  std::vector<std::string> files;
+  {
+    MutexLock lock(&ingest_lock_);
+    files.swap(ingest_files_[table]);
   }
+  if (files.empty())
+    return DB::kOK;
+  // The files are in the DB directory, so they are linked rather than copied.
+  rocksdb::IngestExternalFileOptions options;
+  options.move_files = true;
+  rocksdb::Status s = rocksdb_->IngestExternalFile(cfh, files, options);
+  if (!s.ok()) {
+    printf("cannot ingest files: %s\n", s.ToString().c_str());
+    return DB::kError;
+  }
+  return DB::kOK;
+}
+
+namespace {
+
+struct ScanIterator {
+  const RocksdbDB* db;
+  rocksdb::ColumnFamilyHandle* cfh;
+  std::unique_ptr<rocksdb::Iterator> it;
+};
+
+// The iterators kept by this thread, released by RocksdbDB::Close().
+std::vector<ScanIterator>& ThreadScanIterators() {
+  thread_local std::vector<ScanIterator> iterators;
+  return iterators;
+}
+
+} // namespace
+
+void RocksdbDB::Close() {
+  std::vector<ScanIterator>& iterators = ThreadScanIterators();
+  for (size_t i = 0; i < iterators.size(); ) {
+    if (iterators[i].db == this) {
+      std::swap(iterators[i], iterators.back());
+      iterators.pop_back();
+    } else {
+      i++;
+    }
+  }
+}
+
+int RocksdbDB::SaveCheckpoint(const std::string &dir) {
+  if (blob_db_ != nullptr)
+    return DB::kNotImplemented;
+  rocksdb::Status s = ycsbc::SaveCheckpoint(rocksdb_, dir, rocksdb_->GetOptions());
+  if (!s.ok()) {
+    printf("cannot save checkpoint %s: %s\n", dir.c_str(), s.ToString().c_str());
+    return DB::kError;
+  }
+  return DB::kOK;
+}
+
+void RocksdbDB::ExportStats(MeasurementsExporter *exporter) {
+  if (stats_)
+    stats_->Export(exporter);
+  if (sim_caches_)
+    sim_caches_->Export(exporter);
+  if (blob_db_ != nullptr) {
+    uint64_t files = 0, bytes = 0;
+    AddBlobFiles(&files, &bytes);
+    exporter->write("ROCKSDB-BLOB", "BlobFiles", files);
+    exporter->write("ROCKSDB-BLOB", "BlobFileBytes", bytes);
+  }
+}
+
+void RocksdbDB::ResetStats() {
+  if (stats_)
+    stats_->Reset();
+  if (sim_caches_)
+    sim_caches_->Reset();
+}
+
+void RocksdbDB::AddBlobFiles(uint64_t* files, uint64_t* bytes) {
+  if (blob_db_ == nullptr)
+    return;
+  rocksdb::Env* env = rocksdb_->GetEnv();
+  std::string dir = rocksdb_->GetName() + "/" + blob_dir_;
+  std::vector<std::string> children;
+  if (!env->GetChildren(dir, &children).ok())
+    return;
+  const std::string suffix = ".blob";
+  for (const std::string& child : children) {
+    if (child.size() <= suffix.size() ||
+        child.compare(child.size() - suffix.size(), suffix.size(), suffix) != 0)
+      continue;
+    uint64_t size;
+    // A file evicted meanwhile is not counted.
+    if (env->GetFileSize(dir + "/" + child, &size).ok()) {
+      (*files)++;
+      *bytes += size;
+    }
+  }
+}
+
+rocksdb::Iterator* RocksdbDB::GetScanIterator(const std::string &table,
+                                              std::unique_ptr<rocksdb::Iterator>* owned) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
+    return nullptr;
+  return scan_iterator(cfh, owned);
+}
+
+rocksdb::Iterator* RocksdbDB::scan_iterator(rocksdb::ColumnFamilyHandle* cfh,
+                                            std::unique_ptr<rocksdb::Iterator>* owned) {
+  if (!reuse_scan_iterator_) {
+    owned->reset(rocksdb_->NewIterator(scan_options_, cfh));
+    return owned->get();
+  }
+  for (ScanIterator& s : ThreadScanIterators()) {
+    if (s.db == this && s.cfh == cfh) {
+      // Refresh() moves the iterator to the latest data; if that fails,
+      // start over with a new one.
+      if (!s.it->Refresh().ok())
+        s.it.reset(rocksdb_->NewIterator(scan_options_, cfh));
+      return s.it.get();
+    }
+  }
+  ScanIterator s;
+  s.db = this;
+  s.cfh = cfh;
+  s.it.reset(rocksdb_->NewIterator(scan_options_, cfh));
+  ThreadScanIterators().push_back(std::move(s));
+  return ThreadScanIterators().back().it.get();
+}
+
+RocksdbDB::OpenDB RocksdbDB::open(const RocksdbOptions& options) {
+  OpenDB db = { nullptr, nullptr, {} };
+  rocksdb::Status s;
+  if (options.blob()) {
+    s = rocksdb::blob_db::BlobDB::Open(options.options(), options.blob_options(),
+                                       restore_checkpoint(options), options.column_families(),
+                                       &db.handles, &db.blob_db);
+    db.db = db.blob_db;
+  } else {
+    s = rocksdb::DB::Open(options.options(), restore_checkpoint(options),
+                          options.column_families(), &db.handles, &db.db);
+  }
+  if (!s.ok()) {
+    printf("cannot open rocksdb: %s\n", s.ToString().c_str());
+    exit(-1);
+  }
+  return db;
+}
+
+void RocksdbDB::multi_get(rocksdb::ColumnFamilyHandle* cfh, size_t n, const rocksdb::Slice* keys,
+                          rocksdb::PinnableSlice* values, rocksdb::Status* statuses) {
+  if (blob_db_ == nullptr) {
+    rocksdb_->MultiGet(rocksdb::ReadOptions(), cfh, n, keys, values, statuses);
+    return;
+  }
+  for (size_t i = 0; i < n; ++i)
+    statuses[i] = rocksdb_->Get(rocksdb::ReadOptions(), cfh, keys[i], &values[i]);
+}
+
+const std::string& RocksdbDB::restore_checkpoint(const RocksdbOptions& options) {
+  if (options.checkpoint_restore().empty())
+    return options.path();
+  uint64_t st = utils::NowNanos();
+  rocksdb::Status s = RestoreCheckpoint(options.checkpoint_restore(), options.path(),
+                                        options.options());
+  if (!s.ok()) {
+    printf("cannot restore checkpoint %s: %s\n", options.checkpoint_restore().c_str(),
+           s.ToString().c_str());
+    exit(-1);
+  }
+  std::cerr << "# Restoring checkpoint (sec):\t" << (utils::NowNanos() - st) / 1e9 << std::endl;
+  return options.path();
+}
+
+void RocksdbDB::add_columnfamilies(const rocksdb::Options& db_options,
+                                   const std::vector<rocksdb::ColumnFamilyDescriptor>& column_families) {
+  // Column families created later on get the options of the default one.
+  cf_options_ = rocksdb::ColumnFamilyOptions(db_options);
+  for (int i = 0; i < (int)(column_families.size()); i++) {
+    column_families_.Add(column_families[i].name, column_families_handles_[i]);
+    if (column_families[i].name == rocksdb::kDefaultColumnFamilyName)
+      cf_options_ = column_families[i].options;
+  }
+}
+
+void RocksdbDB::configure(const RocksdbOptions& options) {
+  merge_updates_ = options.merge_updates();
+  write_options_ = options.write_options();
+  record_format_ = options.record_format();
+  scan_options_ = options.scan_options();
+  scan_upper_bound_ = options.scan_upper_bound();
+  if (!scan_upper_bound_.empty()) {
+    scan_upper_bound_slice_ = rocksdb::Slice(scan_upper_bound_);
+    scan_options_.iterate_upper_bound = &scan_upper_bound_slice_;
+  }
+  reuse_scan_iterator_ = options.reuse_scan_iterator();
+  stats_ = options.stats();
+  sim_caches_ = options.sim_caches();
+  timeline_ = options.timeline();
+  if (timeline_)
+    timeline_->Attach(rocksdb_, &column_families_);
+}
+
+rocksdb::ColumnFamilyHandle* RocksdbDB::get_columnfamily(const std::string& table) {
+  // A BlobDB cannot create column families.
+  if (blob_db_ != nullptr)
+    return rocksdb_->DefaultColumnFamily();
+  rocksdb::ColumnFamilyHandle* cfh = column_families_.Find(table);
+  if (cfh == nullptr && create_columnfamily(table) == 0)
+    cfh = column_families_.Find(table);
+  return cfh;
 }
 
 int RocksdbDB::create_columnfamily(const std::string& name) {
-  WriteLock lock(&cf_lock_);
-  if (column_families_map_.count(name) == 0) {
-    rocksdb::ColumnFamilyOptions cfo;
-    cfo.OptimizeLevelStyleCompaction();
+  MutexLock lock(&cf_lock_);
+  if (column_families_.Find(name) == nullptr) {
     rocksdb::ColumnFamilyHandle* cfh;
-    rocksdb::Status s = rocksdb_->CreateColumnFamily(cfo, name, &cfh);
-    rocksdb::ColumnFamilyDescriptor cfd;
-    if (s.ok() && cfh->GetDescriptor(&cfd).ok()) {
-      column_families_map_.emplace(name, column_families_.size());
-      column_families_.push_back(cfd);
-      column_families_handles_.push_back(cfh);
-    }
-    else
+    rocksdb::Status s = rocksdb_->CreateColumnFamily(cf_options_, name, &cfh);
+    if (!s.ok())
       return -1;
+    column_families_handles_.push_back(cfh);
+    column_families_.Add(name, cfh);
   }
   return 0;
 }
@@ -12,19 +12,24 @@
 #include <iostream>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #include "core/properties.h"
+#include "db/column_family_registry.h"
+#include "db/record_codec.h"
+#include "db/rocksdb_options.h"
+#include "db/rocksdb_stats.h"
 #include "rocksdb-cloud/include/rocksdb/db.h"
 #include "rocksdb-cloud/include/rocksdb/options.h"
+#include "rocksdb-cloud/include/rocksdb/sst_file_writer.h"
+#include "rocksdb-cloud/include/rocksdb/write_batch.h"
 
 using std::cout;
 using std::endl;
 
 namespace ycsbc {
 
-class RocksdbDB : public DB {
+class RocksdbDB : public DB, public SliceDB, public IngestDB {
  public:
   RocksdbDB(const rocksdb::Options& db_options, const std::string& dbpath) {
     rocksdb::Status s = rocksdb::DB::Open(db_options, dbpath, &rocksdb_);
@@ -32,9 +37,9 @@ class RocksdbDB : public DB {
       printf("cannot open rocksdb: %s\n", s.ToString().c_str());
       exit(-1);
     }
-    column_families_map_.emplace("default", 0);
+    cf_options_ = rocksdb::ColumnFamilyOptions(db_options);
     column_families_handles_.push_back(rocksdb_->DefaultColumnFamily());
-    column_families_.push_back(rocksdb::ColumnFamilyDescriptor("default", rocksdb::ColumnFamilyOptions()));
+    column_families_.Add(rocksdb::kDefaultColumnFamilyName, rocksdb_->DefaultColumnFamily());
   }
   RocksdbDB(const rocksdb::Options& db_options, const std::string& dbpath,
             const std::vector<rocksdb::ColumnFamilyDescriptor>& column_families) {
@@ -43,20 +48,36 @@ class RocksdbDB : public DB {
       printf("cannot open rocksdb: %s\n", s.ToString().c_str());
       exit(-1);
     }
-    for (int i = 0; i < (int)(column_families.size()); i++) {
-      column_families_map_.emplace(column_families[i].name, i);
-      column_families_.push_back(column_families[i]);
-    }
+    add_columnfamilies(db_options, column_families);
   }
 
+  ///
+  /// Opens the DB in options.path(), as a BlobDB if options.blob() is set,
+  /// in which case every table is kept in the default column family.
+  ///
+  RocksdbDB(const RocksdbOptions& options) : RocksdbDB(options, open(options)) {}
+
   ~RocksdbDB() {
+    // The listener may serve other shards; it must not keep a deleted DB.
+    if (timeline_)
+      timeline_->Detach(rocksdb_);
     delete rocksdb_;
   }
 
+  /// Drops the scan iterators kept by the calling thread.
+  void Close();
+
   int Read(const std::string &table, const std::string &key,
            const std::vector<std::string> *fields,
            std::vector<KVPair> &result);
 
+  /// Looks the keys up with one batched MultiGet, or one Get() each in a
+  /// BlobDB, which has no batched MultiGet.
+  int MultiRead(const std::string &table, const std::vector<std::string> &keys,
+                const std::vector<std::string> *fields,
+                std::vector<std::vector<KVPair>> &results,
+                std::vector<int> &statuses);
+
   int Scan(const std::string &table, const std::string &key,
            int len, const std::vector<std::string> *fields,
            std::vector<std::vector<KVPair>> &result);
@@ -67,26 +88,147 @@ class RocksdbDB : public DB {
   int Insert(const std::string &table, const std::string &key,
              std::vector<KVPair> &values);
 
+  /// Writes the records with one WriteBatch.
+  int BatchInsert(const std::string &table, const std::vector<std::string> &keys,
+                  std::vector<std::vector<KVPair>> &values);
+
   int Delete(const std::string &table, const std::string &key);
 
+  SliceDB *GetSliceDB() { return this; }
+
+  int Read(const std::string &table, const Slice &key,
+           const std::vector<Slice> *fields, ResultBuffer &result);
+
+  int MultiRead(const std::string &table, const std::vector<Slice> &keys,
+                const std::vector<Slice> *fields, ResultBuffer &result,
+                std::vector<int> &statuses);
+
+  int Scan(const std::string &table, const Slice &key,
+           int len, const std::vector<Slice> *fields, ResultBuffer &result);
+
+  int StreamScan(const std::string &table, const Slice &key,
+                 int len, const std::vector<Slice> *fields, ScanVisitor &visitor);
+
+  int Update(const std::string &table, const Slice &key,
+             const std::vector<SliceKVPair> &values);
+
+  int Insert(const std::string &table, const Slice &key,
+             const std::vector<SliceKVPair> &values);
+
+  int Delete(const std::string &table, const Slice &key);
+
+  IngestDB *GetIngestDB() { return this; }
+
+  /// Writes an SST file in the DB directory.
+  RecordFileWriter *NewFileWriter(const std::string &table);
+
+  /// Moves the SST files into the DB with one IngestExternalFile().
+  int IngestFiles(const std::string &table);
+
+  ///
+  /// Flushes the memtables and writes a checkpoint (see SaveCheckpoint()).
+  /// Not implemented for a BlobDB, whose checkpoints leave the blob files
+  /// out.
+  ///
+  int SaveCheckpoint(const std::string &dir);
+
+  ///
+  /// Writes the statistics and perf samples, if rocksdb.statistics is set,
+  /// the hit ratios of rocksdb.simcache.sizes, and for a BlobDB the
+  /// ROCKSDB-BLOB BlobFiles and BlobFileBytes in it.
+  ///
+  void ExportStats(MeasurementsExporter *exporter);
+
+  void ResetStats();
+
+  /// Adds the number and the total size of the blob files of a BlobDB.
+  void AddBlobFiles(uint64_t* files, uint64_t* bytes);
+
+  ///
+  /// Returns an iterator over table with the ReadOptions of scans: the one
+  /// the calling thread keeps, or else a new one left in owned. NULL if the
+  /// column family of table cannot be created.
+  ///
+  rocksdb::Iterator* GetScanIterator(const std::string &table,
+                                     std::unique_ptr<rocksdb::Iterator>* owned);
+
+ protected:
+  ///
+  /// Takes over db, which a subclass opened as a StackableDB with
+  /// options.column_families(), whose handles are handles.
+  ///
+  RocksdbDB(const RocksdbOptions& options, rocksdb::DB* db,
+            const std::vector<rocksdb::ColumnFamilyHandle*>& handles) :
+      rocksdb_(db), column_families_handles_(handles) {
+    add_columnfamilies(options.options(), options.column_families());
+    configure(options);
+  }
+
+  rocksdb::ColumnFamilyHandle* get_columnfamily(const std::string& table);
+
+  // Replaces the DB in options.path() with options.checkpoint_restore(), if
+  // set, and returns the path; exits if that fails.
+  static const std::string& restore_checkpoint(const RocksdbOptions& options);
+
+  RecordFormat record_format() const { return record_format_; }
+  const rocksdb::WriteOptions& write_options() const { return write_options_; }
+
  private:
+  class SstRecordWriter;
+
+  // What open() returns to the constructor.
+  struct OpenDB {
+    rocksdb::DB* db;
+    rocksdb::blob_db::BlobDB* blob_db; // NULL unless options.blob()
+    std::vector<rocksdb::ColumnFamilyHandle*> handles;
+  };
+
+  // Opens the DB of options; exits if that fails.
+  static OpenDB open(const RocksdbOptions& options);
+  RocksdbDB(const RocksdbOptions& options, const OpenDB& db) :
+      RocksdbDB(options, db.db, db.handles) {
+    blob_db_ = db.blob_db;
+    blob_dir_ = options.blob_options().blob_dir;
+  }
+
+  // Looks up n keys of cfh like the batched MultiGet.
+  void multi_get(rocksdb::ColumnFamilyHandle* cfh, size_t n, const rocksdb::Slice* keys,
+                 rocksdb::PinnableSlice* values, rocksdb::Status* statuses);
+
+  // Registers the open column families, whose handles are in
+  // column_families_handles_.
+  void add_columnfamilies(const rocksdb::Options& db_options,
+                          const std::vector<rocksdb::ColumnFamilyDescriptor>& column_families);
+  // Takes the settings of options other than those to open the DB with.
+  void configure(const RocksdbOptions& options);
+
   rocksdb::DB* rocksdb_;
-  std::unordered_map<std::string, int> column_families_map_;
-  std::vector<rocksdb::ColumnFamilyDescriptor> column_families_;
+  rocksdb::blob_db::BlobDB* blob_db_ = nullptr; // rocksdb_ if a BlobDB
+  std::string blob_dir_;
+  ColumnFamilyRegistry column_families_;
+  RecordFormat record_format_ = kLegacyRecord;
   std::vector<rocksdb::ColumnFamilyHandle*> column_families_handles_;
-  RWMutex cf_lock_;
-
-  std::string serialize_values(const std::unordered_map<std::string, std::string>& values);
-  std::string serialize_values(const std::vector<KVPair>& values);
-  void deserialize_values(
-        const std::string& values,
-        const std::unordered_set<std::string>* fields,
-        std::unordered_map<std::string, std::string>* result);
-  void deserialize_values(
-        const std::string& values,
-        const std::unordered_set<std::string>* fields,
-        std::vector<KVPair>* result);
+  rocksdb::ColumnFamilyOptions cf_options_;
+  bool merge_updates_ = false; // Update() merges field patches blindly
+  rocksdb::WriteOptions write_options_;
+  rocksdb::ReadOptions scan_options_;
+  std::string scan_upper_bound_;
+  rocksdb::Slice scan_upper_bound_slice_;
+  bool reuse_scan_iterator_ = false;
+  std::shared_ptr<RocksdbStats> stats_; // NULL without rocksdb.statistics
+  std::shared_ptr<TimelineListener> timeline_;
+  std::shared_ptr<SimCacheCurve> sim_caches_; // NULL without rocksdb.simcache.sizes
+  Mutex cf_lock_; // Serializes create_columnfamily()
+  Mutex ingest_lock_;
+  int num_ingest_files_ = 0;
+  // Finished SST files of each table, waiting for IngestFiles().
+  std::unordered_map<std::string, std::vector<std::string>> ingest_files_;
+
   int create_columnfamily(const std::string& name);
+  // Returns an iterator for a scan of cfh: the one the calling thread keeps
+  // and refreshes, or else a new one left in owned.
+  rocksdb::Iterator* scan_iterator(rocksdb::ColumnFamilyHandle* cfh,
+                                   std::unique_ptr<rocksdb::Iterator>* owned);
 };
 
 } // ycsbc
@@ -0,0 +1,380 @@
+//
+//  rocksdb_options.cc
+//  YCSB-C
+//
+
+#include "db/rocksdb_options.h"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include "core/utils.h"
+#include "db/field_merge_operator.h"
+#include "rocksdb-cloud/include/rocksdb/cache.h"
+#include "rocksdb-cloud/include/rocksdb/env.h"
+#include "rocksdb-cloud/include/rocksdb/filter_policy.h"
+#include "rocksdb-cloud/include/rocksdb/rate_limiter.h"
+#include "rocksdb-cloud/include/rocksdb/statistics.h"
+#include "rocksdb-cloud/include/rocksdb/table.h"
+#include "rocksdb-cloud/include/rocksdb/utilities/options_util.h"
+
+using std::string;
+using ycsbc::RocksdbOptions;
+
+const string RocksdbOptions::DIR_PROPERTY = "rocksdb.dir";
+const string RocksdbOptions::DIR_DEFAULT = "/tmp/YCSB-C_rocksdb/";
+
+const string RocksdbOptions::OPTIONS_FILE_PROPERTY = "rocksdb.optionsfile";
+const string RocksdbOptions::WRITE_BUFFER_SIZE_PROPERTY = "rocksdb.write_buffer_size";
+const string RocksdbOptions::CACHE_SIZE_PROPERTY = "rocksdb.cache_size";
+const string RocksdbOptions::SIMCACHE_SIZES_PROPERTY = "rocksdb.simcache.sizes";
+const string RocksdbOptions::BLOOM_BITS_PROPERTY = "rocksdb.bloom_bits";
+const string RocksdbOptions::COMPRESSION_PROPERTY = "rocksdb.compression";
+const string RocksdbOptions::COMPRESSION_PER_LEVEL_PROPERTY =
+    "rocksdb.compression_per_level";
+const string RocksdbOptions::MAX_BACKGROUND_JOBS_PROPERTY =
+    "rocksdb.max_background_jobs";
+const string RocksdbOptions::COMPACTION_STYLE_PROPERTY = "rocksdb.compaction_style";
+const string RocksdbOptions::RATE_LIMIT_PROPERTY = "rocksdb.rate_limit";
+
+const string RocksdbOptions::UPDATE_MODE_PROPERTY = "rocksdb.update_mode";
+const string RocksdbOptions::UPDATE_MODE_DEFAULT = "readmodifywrite";
+
+const string RocksdbOptions::RECORD_FORMAT_PROPERTY = "rocksdb.record_format";
+const string RocksdbOptions::RECORD_FORMAT_DEFAULT = "legacy";
+
+const string RocksdbOptions::SCAN_READAHEAD_SIZE_PROPERTY = "rocksdb.scan.readahead_size";
+const string RocksdbOptions::SCAN_FILL_CACHE_PROPERTY = "rocksdb.scan.fill_cache";
+const string RocksdbOptions::SCAN_PIN_DATA_PROPERTY = "rocksdb.scan.pin_data";
+const string RocksdbOptions::SCAN_UPPER_BOUND_PROPERTY = "rocksdb.scan.upper_bound";
+const string RocksdbOptions::SCAN_REUSE_ITERATOR_PROPERTY = "rocksdb.scan.reuse_iterator";
+const string RocksdbOptions::SCAN_REUSE_ITERATOR_DEFAULT = "false";
+
+const string RocksdbOptions::STATISTICS_PROPERTY = "rocksdb.statistics";
+const string RocksdbOptions::STATISTICS_DEFAULT = "false";
+const string RocksdbOptions::PERF_SAMPLE_RATE_PROPERTY = "rocksdb.perf_sample_rate";
+const string RocksdbOptions::PERF_SAMPLE_RATE_DEFAULT = "0.01";
+
+const string RocksdbOptions::BLOB_PROPERTY = "rocksdb.blob";
+const string RocksdbOptions::BLOB_DEFAULT = "false";
+const string RocksdbOptions::BLOB_MIN_SIZE_PROPERTY = "rocksdb.blob.min_blob_size";
+const string RocksdbOptions::BLOB_MIN_SIZE_DEFAULT = "0";
+const string RocksdbOptions::BLOB_FILE_SIZE_PROPERTY = "rocksdb.blob.file_size";
+const string RocksdbOptions::BLOB_GC_PROPERTY = "rocksdb.blob.gc";
+const string RocksdbOptions::BLOB_GC_DEFAULT = "none";
+const string RocksdbOptions::BLOB_MAX_DB_SIZE_PROPERTY = "rocksdb.blob.max_db_size";
+const string RocksdbOptions::BLOB_MAX_DB_SIZE_DEFAULT = "0";
+
+const string RocksdbOptions::SHARDS_PROPERTY = "rocksdb.shards";
+const string RocksdbOptions::SHARDS_DEFAULT = "4";
+const string RocksdbOptions::SHARDS_SHARED_CACHE_PROPERTY = "rocksdb.shards.shared_cache";
+const string RocksdbOptions::SHARDS_SHARED_CACHE_DEFAULT = "true";
+const string RocksdbOptions::SHARDS_SHARED_RATE_LIMITER_PROPERTY =
+    "rocksdb.shards.shared_rate_limiter";
+const string RocksdbOptions::SHARDS_SHARED_RATE_LIMITER_DEFAULT = "true";
+
+const string RocksdbOptions::TXN_LOCK_TIMEOUT_PROPERTY = "rocksdb.txn.lock_timeout";
+const string RocksdbOptions::TXN_LOCK_TIMEOUT_DEFAULT = "1000";
+const string RocksdbOptions::TXN_DEADLOCK_DETECT_PROPERTY = "rocksdb.txn.deadlock_detect";
+const string RocksdbOptions::TXN_DEADLOCK_DETECT_DEFAULT = "true";
+const string RocksdbOptions::TXN_MAX_RETRIES_PROPERTY = "rocksdb.txn.max_retries";
+const string RocksdbOptions::TXN_MAX_RETRIES_DEFAULT = "10";
+
+const string RocksdbOptions::TIMELINE_FILE_PROPERTY = "rocksdb.timeline_file";
+
+const string RocksdbOptions::CHECKPOINT_RESTORE_PROPERTY = "checkpoint.restore";
+
+const string RocksdbOptions::LOAD_DISABLE_WAL_PROPERTY = "load.disable_wal";
+const string RocksdbOptions::LOAD_DISABLE_WAL_DEFAULT = "false";
+const string RocksdbOptions::LOAD_UNORDERED_WRITES_PROPERTY = "load.unordered_writes";
+const string RocksdbOptions::LOAD_UNORDERED_WRITES_DEFAULT = "false";
+
+namespace {
+
+rocksdb::CompressionType ParseCompression(const string &name) {
+  if (name == "none") return rocksdb::kNoCompression;
+  if (name == "snappy") return rocksdb::kSnappyCompression;
+  if (name == "zlib") return rocksdb::kZlibCompression;
+  if (name == "bzip2") return rocksdb::kBZip2Compression;
+  if (name == "lz4") return rocksdb::kLZ4Compression;
+  if (name == "lz4hc") return rocksdb::kLZ4HCCompression;
+  if (name == "xpress") return rocksdb::kXpressCompression;
+  if (name == "zstd") return rocksdb::kZSTD;
+  throw utils::Exception("Unknown compression: " + name);
+}
+
+// Parses a size in bytes with an optional K, M, G or T suffix.
+size_t ParseSize(const string &str) {
+  size_t end;
+  double size = std::stod(str, &end);
+  string suffix = utils::Trim(str.substr(end));
+  if (suffix.empty()) return (size_t)size;
+  switch (std::toupper((unsigned char)suffix[0])) {
+    case 'K': return (size_t)(size * (1ull << 10));
+    case 'M': return (size_t)(size * (1ull << 20));
+    case 'G': return (size_t)(size * (1ull << 30));
+    case 'T': return (size_t)(size * (1ull << 40));
+  }
+  throw utils::Exception("Invalid size: " + str);
+}
+
+// Gives the block based tables of cf_options the block cache cache; with
+// NULL, each table factory makes a default cache of its own.
+void ReplaceBlockCache(rocksdb::ColumnFamilyOptions *cf_options,
+                       const std::shared_ptr<rocksdb::Cache> &cache) {
+  if (!cf_options->table_factory ||
+      cf_options->table_factory->Name() != std::string("BlockBasedTable") ||
+      cf_options->table_factory->GetOptions() == nullptr)
+    return;
+  rocksdb::BlockBasedTableOptions table_options =
+      *static_cast<rocksdb::BlockBasedTableOptions*>(cf_options->table_factory->GetOptions());
+  table_options.block_cache = cache;
+  cf_options->table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+}
+
+} // namespace
+
+RocksdbOptions::RocksdbOptions(const utils::Properties &props) :
+    merge_updates_(false), record_format_(kLegacyRecord), reuse_scan_iterator_(false),
+    shards_(1), blob_(false), share_cache_(true), share_rate_limiter_(true),
+    txn_lock_timeout_(1000), txn_deadlock_detect_(true), txn_max_retries_(10) {
+  path_ = props.GetProperty(DIR_PROPERTY, DIR_DEFAULT);
+
+  string update_mode = props.GetProperty(UPDATE_MODE_PROPERTY, UPDATE_MODE_DEFAULT);
+  if (update_mode == "merge")
+    merge_updates_ = true;
+  else if (update_mode != "readmodifywrite")
+    throw utils::Exception("Unknown update mode: " + update_mode);
+
+  string record_format = props.GetProperty(RECORD_FORMAT_PROPERTY, RECORD_FORMAT_DEFAULT);
+  if (record_format == "compact")
+    record_format_ = kCompactRecord;
+  else if (record_format != "legacy")
+    throw utils::Exception("Unknown record format: " + record_format);
+
+  string readahead = props.GetProperty(SCAN_READAHEAD_SIZE_PROPERTY, "");
+  if (!readahead.empty())
+    scan_options_.readahead_size = std::stoull(readahead);
+  string fill_cache = props.GetProperty(SCAN_FILL_CACHE_PROPERTY, "");
+  if (!fill_cache.empty())
+    scan_options_.fill_cache = utils::StrToBool(fill_cache);
+  string pin_data = props.GetProperty(SCAN_PIN_DATA_PROPERTY, "");
+  if (!pin_data.empty())
+    scan_options_.pin_data = utils::StrToBool(pin_data);
+  scan_upper_bound_ = props.GetProperty(SCAN_UPPER_BOUND_PROPERTY, "");
+  reuse_scan_iterator_ = utils::StrToBool(props.GetProperty(
+      SCAN_REUSE_ITERATOR_PROPERTY, SCAN_REUSE_ITERATOR_DEFAULT));
+
+  string options_file = props.GetProperty(OPTIONS_FILE_PROPERTY, "");
+  if (options_file.empty()) {
+    options_.OptimizeLevelStyleCompaction();
+  } else {
+    rocksdb::DBOptions db_options;
+    rocksdb::Status s = rocksdb::LoadOptionsFromFile(
+        options_file, rocksdb::Env::Default(), &db_options, &column_families_);
+    if (!s.ok())
+      throw utils::Exception("Cannot load " + options_file + ": " + s.ToString());
+    rocksdb::ColumnFamilyOptions default_cf_options;
+    for (const rocksdb::ColumnFamilyDescriptor &cf : column_families_) {
+      if (cf.name == rocksdb::kDefaultColumnFamilyName)
+        default_cf_options = cf.options;
+    }
+    options_ = rocksdb::Options(db_options, default_cf_options);
+    options_.create_missing_column_families = true;
+  }
+  options_.create_if_missing = true;
+
+  string jobs = props.GetProperty(MAX_BACKGROUND_JOBS_PROPERTY, "");
+  if (!jobs.empty())
+    options_.max_background_jobs = std::stoi(jobs);
+  string rate_limit = props.GetProperty(RATE_LIMIT_PROPERTY, "");
+  if (!rate_limit.empty() && std::stoll(rate_limit) > 0)
+    options_.rate_limiter.reset(rocksdb::NewGenericRateLimiter(std::stoll(rate_limit)));
+
+  blob_ = utils::StrToBool(props.GetProperty(BLOB_PROPERTY, BLOB_DEFAULT));
+  if (blob_) {
+    if (merge_updates_)
+      throw utils::Exception("rocksdb.blob cannot merge updates");
+    blob_options_.min_blob_size = std::stoull(props.GetProperty(
+        BLOB_MIN_SIZE_PROPERTY, BLOB_MIN_SIZE_DEFAULT));
+    string file_size = props.GetProperty(BLOB_FILE_SIZE_PROPERTY, "");
+    if (!file_size.empty())
+      blob_options_.blob_file_size = std::stoull(file_size);
+    blob_options_.max_db_size = std::stoull(props.GetProperty(
+        BLOB_MAX_DB_SIZE_PROPERTY, BLOB_MAX_DB_SIZE_DEFAULT));
+    string gc = props.GetProperty(BLOB_GC_PROPERTY, BLOB_GC_DEFAULT);
+    if (gc == "fifo") {
+      if (blob_options_.max_db_size == 0)
+        throw utils::Exception("rocksdb.blob.gc=fifo needs rocksdb.blob.max_db_size");
+      blob_options_.is_fifo = true;
+    } else if (gc != "none") {
+      throw utils::Exception("Unknown blob GC policy: " + gc);
+    }
+  }
+
+  if (utils::StrToBool(props.GetProperty(STATISTICS_PROPERTY, STATISTICS_DEFAULT))) {
+    options_.statistics = rocksdb::CreateDBStatistics();
+    double sample_rate = std::stod(props.GetProperty(
+        PERF_SAMPLE_RATE_PROPERTY, PERF_SAMPLE_RATE_DEFAULT));
+    if (sample_rate < 0 || sample_rate > 1)
+      throw utils::Exception("rocksdb.perf_sample_rate must be between 0 and 1");
+    stats_ = std::make_shared<RocksdbStats>(options_.statistics, sample_rate, blob_);
+  }
+
+  shards_ = std::stoi(props.GetProperty(SHARDS_PROPERTY, SHARDS_DEFAULT));
+  if (shards_ < 1)
+    throw utils::Exception("rocksdb.shards must be positive");
+  share_cache_ = utils::StrToBool(props.GetProperty(
+      SHARDS_SHARED_CACHE_PROPERTY, SHARDS_SHARED_CACHE_DEFAULT));
+  share_rate_limiter_ = utils::StrToBool(props.GetProperty(
+      SHARDS_SHARED_RATE_LIMITER_PROPERTY, SHARDS_SHARED_RATE_LIMITER_DEFAULT));
+
+  txn_lock_timeout_ = std::stoll(props.GetProperty(
+      TXN_LOCK_TIMEOUT_PROPERTY, TXN_LOCK_TIMEOUT_DEFAULT));
+  txn_deadlock_detect_ = utils::StrToBool(props.GetProperty(
+      TXN_DEADLOCK_DETECT_PROPERTY, TXN_DEADLOCK_DETECT_DEFAULT));
+  txn_max_retries_ = std::stoi(props.GetProperty(
+      TXN_MAX_RETRIES_PROPERTY, TXN_MAX_RETRIES_DEFAULT));
+  if (txn_max_retries_ < 0)
+    throw utils::Exception("rocksdb.txn.max_retries must not be negative");
+
+  checkpoint_restore_ = props.GetProperty(CHECKPOINT_RESTORE_PROPERTY, "");
+
+  string timeline_file = props.GetProperty(TIMELINE_FILE_PROPERTY, "");
+  if (!timeline_file.empty()) {
+    timeline_ = std::make_shared<TimelineListener>(timeline_file);
+    options_.listeners.push_back(timeline_);
+  }
+
+  if (props.GetProperty("command", "") == "load") {
+    write_options_.disableWAL = utils::StrToBool(props.GetProperty(
+        LOAD_DISABLE_WAL_PROPERTY, LOAD_DISABLE_WAL_DEFAULT));
+    options_.enable_pipelined_write = utils::StrToBool(props.GetProperty(
+        LOAD_UNORDERED_WRITES_PROPERTY, LOAD_UNORDERED_WRITES_DEFAULT));
+  }
+
+  string sim_sizes = props.GetProperty(SIMCACHE_SIZES_PROPERTY, "");
+  if (!sim_sizes.empty()) {
+    string cache_size = props.GetProperty(CACHE_SIZE_PROPERTY, "");
+    if (cache_size.empty())
+      throw utils::Exception("rocksdb.simcache.sizes needs rocksdb.cache_size");
+    std::vector<SimCacheCurve::Size> sizes;
+    std::stringstream ss(sim_sizes);
+    string name;
+    while (std::getline(ss, name, ',')) {
+      name = utils::Trim(name);
+      size_t capacity = ParseSize(name);
+      // Blocks a smaller cache would miss are not inserted into it when
+      // the real cache has them, so it would report too many misses.
+      if (capacity < std::stoull(cache_size))
+        throw utils::Exception("rocksdb.simcache.sizes must be at least rocksdb.cache_size");
+      sizes.push_back(SimCacheCurve::Size{name, capacity});
+    }
+    sim_caches_ = std::make_shared<SimCacheCurve>(sizes);
+  }
+
+  ApplyProperties(props, &options_);
+  for (rocksdb::ColumnFamilyDescriptor &cf : column_families_)
+    ApplyProperties(props, &cf.options);
+  if (column_families_.empty()) {
+    column_families_.push_back(rocksdb::ColumnFamilyDescriptor(
+        rocksdb::kDefaultColumnFamilyName, options_));
+  }
+  if (blob_ && column_families_.size() > 1)
+    throw utils::Exception("rocksdb.blob only supports the default column family");
+}
+
+void RocksdbOptions::ApplyProperties(const utils::Properties &props,
+                                     rocksdb::ColumnFamilyOptions *cf_options) {
+  string write_buffer_size = props.GetProperty(WRITE_BUFFER_SIZE_PROPERTY, "");
+  if (!write_buffer_size.empty())
+    cf_options->write_buffer_size = std::stoull(write_buffer_size);
+
+  string style = props.GetProperty(COMPACTION_STYLE_PROPERTY, "");
+  if (style == "level") {
+    cf_options->compaction_style = rocksdb::kCompactionStyleLevel;
+  } else if (style == "universal") {
+    cf_options->compaction_style = rocksdb::kCompactionStyleUniversal;
+  } else if (style == "fifo") {
+    cf_options->compaction_style = rocksdb::kCompactionStyleFIFO;
+  } else if (!style.empty()) {
+    throw utils::Exception("Unknown compaction style: " + style);
+  }
+
+  string compression = props.GetProperty(COMPRESSION_PROPERTY, "");
+  if (!compression.empty()) {
+    cf_options->compression = ParseCompression(compression);
+    cf_options->compression_per_level.clear();
+  }
+  string per_level = props.GetProperty(COMPRESSION_PER_LEVEL_PROPERTY, "");
+  if (!per_level.empty()) {
+    cf_options->compression_per_level.clear();
+    std::stringstream ss(per_level);
+    string name;
+    while (std::getline(ss, name, ','))
+      cf_options->compression_per_level.push_back(ParseCompression(utils::Trim(name)));
+  }
+
+  if (merge_updates_) {
+    if (!merge_operator_)
+      merge_operator_ = std::make_shared<FieldMergeOperator>(record_format_);
+    cf_options->merge_operator = merge_operator_;
+  }
+
+  string cache_size = props.GetProperty(CACHE_SIZE_PROPERTY, "");
+  string bloom_bits = props.GetProperty(BLOOM_BITS_PROPERTY, "");
+  if (cache_size.empty() && bloom_bits.empty())
+    return;
+  // Start from the table options of the options file, if any.
+  rocksdb::BlockBasedTableOptions table_options;
+  if (cf_options->table_factory &&
+      cf_options->table_factory->Name() == std::string("BlockBasedTable") &&
+      cf_options->table_factory->GetOptions() != nullptr) {
+    table_options = *static_cast<rocksdb::BlockBasedTableOptions*>(
+        cf_options->table_factory->GetOptions());
+  }
+  if (!cache_size.empty()) {
+    if (!block_cache_) {
+      block_cache_ = rocksdb::NewLRUCache(std::stoull(cache_size));
+      if (sim_caches_)
+        block_cache_ = sim_caches_->Wrap(block_cache_);
+    }
+    table_options.block_cache = block_cache_;
+  }
+  if (!bloom_bits.empty()) {
+    int bits = std::stoi(bloom_bits);
+    if (bits > 0)
+      table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(bits, false));
+    else
+      table_options.filter_policy.reset();
+  }
+  cf_options->table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+}
+
+RocksdbOptions RocksdbOptions::ForShard(int i) const {
+  RocksdbOptions shard(*this);
+  shard.path_ = ShardPath(path_, i);
+  if (!checkpoint_restore_.empty())
+    shard.checkpoint_restore_ = ShardPath(checkpoint_restore_, i);
+  if (!share_cache_) {
+    shard.block_cache_.reset();
+    if (block_cache_)
+      shard.block_cache_ = rocksdb::NewLRUCache(block_cache_->GetCapacity() / shards_);
+    if (sim_caches_ && shard.block_cache_)
+      shard.block_cache_ = sim_caches_->Wrap(shard.block_cache_, shards_);
+    ReplaceBlockCache(&shard.options_, shard.block_cache_);
+    for (rocksdb::ColumnFamilyDescriptor &cf : shard.column_families_)
+      ReplaceBlockCache(&cf.options, shard.block_cache_);
+  }
+  // Every shard evicts its own blob files.
+  shard.blob_options_.max_db_size = blob_options_.max_db_size / shards_;
+  if (!share_rate_limiter_ && options_.rate_limiter) {
+    shard.options_.rate_limiter.reset(rocksdb::NewGenericRateLimiter(
+        std::max((int64_t)1, options_.rate_limiter->GetBytesPerSecond() / shards_)));
+  }
+  return shard;
+}
+
+string RocksdbOptions::ShardPath(const string &dir, int i) {
+  return dir + (dir.empty() || dir.back() != '/' ? "/" : "") + "shard-" + std::to_string(i);
+}
@@ -0,0 +1,339 @@
+//
+//  rocksdb_options.h
+//  YCSB-C
+//
+
+#ifndef YCSB_C_ROCKSDB_OPTIONS_H_
+#define YCSB_C_ROCKSDB_OPTIONS_H_
+
+#include <string>
+#include <vector>
+
+#include "core/properties.h"
+#include "db/record_codec.h"
+#include "db/rocksdb_sim_cache.h"
+#include "db/rocksdb_stats.h"
+#include "db/rocksdb_timeline.h"
+#include "rocksdb-cloud/include/rocksdb/db.h"
+#include "rocksdb-cloud/include/rocksdb/options.h"
+#include "rocksdb-cloud/utilities/blob_db/blob_db.h"
+
+namespace ycsbc {
+
+///
+/// Options of the RocksDB binding, built from rocksdb.* properties.
+/// Without any, the binding keeps its historical defaults: level style
+/// compaction tuned by OptimizeLevelStyleCompaction().
+///
+class RocksdbOptions {
+ public:
+  ///
+  /// The name of the property for the directory of the database.
+  ///
+  static const std::string DIR_PROPERTY;
+  static const std::string DIR_DEFAULT;
+
+  ///
+  /// The name of the property for a RocksDB OPTIONS file to start from.
+  /// Its DB options and column families replace the defaults, and the
+  /// properties below are applied on top of them.
+  ///
+  static const std::string OPTIONS_FILE_PROPERTY;
+
+  ///
+  /// The name of the property for the memtable size in bytes.
+  ///
+  static const std::string WRITE_BUFFER_SIZE_PROPERTY;
+
+  ///
+  /// The name of the property for the size of the LRU block cache in bytes,
+  /// shared by all column families.
+  ///
+  static const std::string CACHE_SIZE_PROPERTY;
+
+  ///
+  /// The name of the property for the block cache sizes to simulate, e.g.
+  /// "1G,2G,4G,8G" (with an optional K, M, G or T suffix), whose hit ratios
+  /// are reported with the statistics (see SimCacheCurve). The sizes must
+  /// be at least rocksdb.cache_size.
+  ///
+  static const std::string SIMCACHE_SIZES_PROPERTY;
+
+  ///
+  /// The name of the property for the bits per key of the bloom filter.
+  /// Zero disables it.
+  ///
+  static const std::string BLOOM_BITS_PROPERTY;
+
+  ///
+  /// The name of the property for the compression of all levels.
+  /// Options are "none", "snappy", "zlib", "bzip2", "lz4", "lz4hc", "xpress"
+  /// and "zstd".
+  ///
+  static const std::string COMPRESSION_PROPERTY;
+
+  ///
+  /// The name of the property for the compression of each level, as a
+  /// comma-separated list of the names above starting from L0.
+  ///
+  static const std::string COMPRESSION_PER_LEVEL_PROPERTY;
+
+  ///
+  /// The name of the property for the number of background flush and
+  /// compaction threads.
+  ///
+  static const std::string MAX_BACKGROUND_JOBS_PROPERTY;
+
+  ///
+  /// The name of the property for the rate limit of flush and compaction
+  /// writes in bytes per second. Zero for none.
+  ///
+  static const std::string RATE_LIMIT_PROPERTY;
+
+  ///
+  /// The name of the property for the compaction style.
+  /// Options are "level", "universal" and "fifo".
+  ///
+  static const std::string COMPACTION_STYLE_PROPERTY;
+
+  ///
+  /// The name of the property for how records are updated.
+  /// Options are "readmodifywrite" (Get the record, patch it and Put it
+  /// back) and "merge" (Merge only the updated fields; a missing record is
+  /// then not reported as such).
+  ///
+  static const std::string UPDATE_MODE_PROPERTY;
+  static const std::string UPDATE_MODE_DEFAULT;
+
+  ///
+  /// The name of the property for the layout of written records.
+  /// Options are "legacy" and "compact" (see RecordFormat). Either layout
+  /// is read whatever the setting.
+  ///
+  static const std::string RECORD_FORMAT_PROPERTY;
+  static const std::string RECORD_FORMAT_DEFAULT;
+
+  ///
+  /// The names of the properties for the ReadOptions of scans: the bytes
+  /// read ahead by iterators, whether scanned blocks go to the block cache,
+  /// whether iterators pin the blocks they have read, and a key at which
+  /// scans stop (empty for none).
+  ///
+  static const std::string SCAN_READAHEAD_SIZE_PROPERTY;
+  static const std::string SCAN_FILL_CACHE_PROPERTY;
+  static const std::string SCAN_PIN_DATA_PROPERTY;
+  static const std::string SCAN_UPPER_BOUND_PROPERTY;
+
+  ///
+  /// The name of the property for deciding whether each client keeps its
+  /// scan iterator and refreshes it for the next scan instead of creating
+  /// one per scan.
+  ///
+  static const std::string SCAN_REUSE_ITERATOR_PROPERTY;
+  static const std::string SCAN_REUSE_ITERATOR_DEFAULT;
+
+  ///
+  /// The name of the property for deciding whether the DB keeps
+  /// rocksdb::Statistics and samples the PerfContext and IOStatsContext of
+  /// operations. They are reported with the measurements.
+  ///
+  static const std::string STATISTICS_PROPERTY;
+  static const std::string STATISTICS_DEFAULT;
+
+  ///
+  /// The name of the property for the fraction of operations whose perf
+  /// and IO contexts are sampled when statistics are enabled.
+  ///
+  static const std::string PERF_SAMPLE_RATE_PROPERTY;
+  static const std::string PERF_SAMPLE_RATE_DEFAULT;
+
+  ///
+  /// The name of the property for the number of DBs the rocksdb-sharded
+  /// binding partitions the keys over.
+  ///
+  static const std::string SHARDS_PROPERTY;
+  static const std::string SHARDS_DEFAULT;
+
+  ///
+  /// The names of the properties for deciding whether the shards share one
+  /// block cache and one rate limiter. Otherwise each shard gets its own,
+  /// of an equal part of rocksdb.cache_size and rocksdb.rate_limit.
+  ///
+  static const std::string SHARDS_SHARED_CACHE_PROPERTY;
+  static const std::string SHARDS_SHARED_CACHE_DEFAULT;
+  static const std::string SHARDS_SHARED_RATE_LIMITER_PROPERTY;
+  static const std::string SHARDS_SHARED_RATE_LIMITER_DEFAULT;
+
+  ///
+  /// The name of the property for deciding whether the rocksdb and
+  /// rocksdb-sharded bindings open the DB as a BlobDB, which keeps values
+  /// in blob files apart from the LSM tree so compactions do not rewrite
+  /// them. A BlobDB has only the default column family, which all tables
+  /// share, and cannot merge updates.
+  ///
+  static const std::string BLOB_PROPERTY;
+  static const std::string BLOB_DEFAULT;
+
+  ///
+  /// The name of the property for the size in bytes from which records are
+  /// stored in blob files; smaller ones stay in the LSM tree.
+  ///
+  static const std::string BLOB_MIN_SIZE_PROPERTY;
+  static const std::string BLOB_MIN_SIZE_DEFAULT;
+
+  ///
+  /// The name of the property for the size in bytes a blob file grows to
+  /// before the next one is started.
+  ///
+  static const std::string BLOB_FILE_SIZE_PROPERTY;
+
+  ///
+  /// The name of the property for how the space of blob files is reclaimed.
+  /// Options are "none" and "fifo", where the oldest blob files, and the
+  /// records in them, are dropped once the DB exceeds
+  /// rocksdb.blob.max_db_size. This BlobDB does not relocate live records
+  /// out of files that are mostly garbage.
+  ///
+  static const std::string BLOB_GC_PROPERTY;
+  static const std::string BLOB_GC_DEFAULT;
+
+  ///
+  /// The name of the property for the max size in bytes of the SST and
+  /// blob files of the DB; writes beyond it fail unless rocksdb.blob.gc is
+  /// "fifo". Zero for no limit. Shards get an equal part each.
+  ///
+  static const std::string BLOB_MAX_DB_SIZE_PROPERTY;
+  static const std::string BLOB_MAX_DB_SIZE_DEFAULT;
+
+  ///
+  /// The name of the property for how long in milliseconds a transaction of
+  /// the rocksdb-txn binding waits for the lock of a key before it aborts.
+  ///
+  static const std::string TXN_LOCK_TIMEOUT_PROPERTY;
+  static const std::string TXN_LOCK_TIMEOUT_DEFAULT;
+
+  ///
+  /// The name of the property for deciding whether the rocksdb-txn binding
+  /// aborts a transaction as soon as its lock wait would close a deadlock,
+  /// instead of when the wait times out.
+  ///
+  static const std::string TXN_DEADLOCK_DETECT_PROPERTY;
+  static const std::string TXN_DEADLOCK_DETECT_DEFAULT;
+
+  ///
+  /// The name of the property for the number of times the rocksdb-txn and
+  /// rocksdb-occ bindings retry a transaction that aborted on a conflict.
+  ///
+  static const std::string TXN_MAX_RETRIES_PROPERTY;
+  static const std::string TXN_MAX_RETRIES_DEFAULT;
+
+  ///
+  /// The name of the property for a file that the flushes, compactions and
+  /// write stalls of the DB are written to (see TimelineListener). Empty
+  /// for none.
+  ///
+  static const std::string TIMELINE_FILE_PROPERTY;
+
+  ///
+  /// The name of the property for a checkpoint (see SaveCheckpoint()) that
+  /// replaces the DB in rocksdb.dir before it is opened, so that every run
+  /// starts from the same data. Empty for none.
+  ///
+  static const std::string CHECKPOINT_RESTORE_PROPERTY;
+
+  ///
+  /// The name of the property for deciding whether the load command writes
+  /// without the write-ahead log. Memtables are still flushed when the
+  /// database is closed, but a crash during the load loses what they hold.
+  ///
+  static const std::string LOAD_DISABLE_WAL_PROPERTY;
+  static const std::string LOAD_DISABLE_WAL_DEFAULT;
+
+  ///
+  /// The name of the property for deciding whether the load command relaxes
+  /// the ordering of concurrent writes for throughput. This RocksDB predates
+  /// DBOptions::unordered_writes, so it enables pipelined writes, which let
+  /// a write group fill the memtable while the next one writes the log.
+  ///
+  static const std::string LOAD_UNORDERED_WRITES_PROPERTY;
+  static const std::string LOAD_UNORDERED_WRITES_DEFAULT;
+
+  ///
+  /// Throws utils::Exception if a property or the options file is invalid.
+  ///
+  RocksdbOptions(const utils::Properties &props);
+
+  const std::string &path() const { return path_; }
+  const rocksdb::Options &options() const { return options_; }
+  const rocksdb::WriteOptions &write_options() const { return write_options_; }
+  ///
+  /// The column families to open: those of the options file, or else the
+  /// default one with options().
+  ///
+  const std::vector<rocksdb::ColumnFamilyDescriptor> &column_families() const {
+    return column_families_;
+  }
+  bool merge_updates() const { return merge_updates_; }
+  RecordFormat record_format() const { return record_format_; }
+  /// The ReadOptions of scans, except for the upper bound.
+  const rocksdb::ReadOptions &scan_options() const { return scan_options_; }
+  const std::string &scan_upper_bound() const { return scan_upper_bound_; }
+  bool reuse_scan_iterator() const { return reuse_scan_iterator_; }
+  /// The statistics of the DB and the perf samples of its operations, or
+  /// NULL if they are disabled.
+  const std::shared_ptr<RocksdbStats> &stats() const { return stats_; }
+  /// The listener registered in options() for rocksdb.timeline_file, or NULL.
+  const std::shared_ptr<TimelineListener> &timeline() const { return timeline_; }
+  /// The simulated caches of rocksdb.simcache.sizes, or NULL.
+  const std::shared_ptr<SimCacheCurve> &sim_caches() const { return sim_caches_; }
+  int shards() const { return shards_; }
+  bool blob() const { return blob_; }
+  const rocksdb::blob_db::BlobDBOptions &blob_options() const { return blob_options_; }
+  const std::string &checkpoint_restore() const { return checkpoint_restore_; }
+  int64_t txn_lock_timeout() const { return txn_lock_timeout_; }
+  bool txn_deadlock_detect() const { return txn_deadlock_detect_; }
+  int txn_max_retries() const { return txn_max_retries_; }
+
+  ///
+  /// Returns the options of shard i of shards(): those of a DB in a
+  /// subdirectory of path(), sharing the statistics, the timeline and the
+  /// simulated caches, and the block cache and the rate limiter unless
+  /// configured otherwise.
+  ///
+  RocksdbOptions ForShard(int i) const;
+
+  /// The subdirectory of dir that shard i is in.
+  static std::string ShardPath(const std::string &dir, int i);
+
+ private:
+  void ApplyProperties(const utils::Properties &props,
+                       rocksdb::ColumnFamilyOptions *cf_options);
+
+  std::string path_;
+  rocksdb::Options options_;
+  rocksdb::WriteOptions write_options_;
+  std::vector<rocksdb::ColumnFamilyDescriptor> column_families_;
+  std::shared_ptr<rocksdb::Cache> block_cache_;
+  std::shared_ptr<rocksdb::MergeOperator> merge_operator_;
+  bool merge_updates_;
+  RecordFormat record_format_;
+  rocksdb::ReadOptions scan_options_;
+  std::string scan_upper_bound_;
+  bool reuse_scan_iterator_;
+  std::shared_ptr<RocksdbStats> stats_;
+  std::shared_ptr<TimelineListener> timeline_;
+  std::shared_ptr<SimCacheCurve> sim_caches_;
+  int shards_;
+  bool blob_;
+  rocksdb::blob_db::BlobDBOptions blob_options_;
+  bool share_cache_;
+  bool share_rate_limiter_;
+  std::string checkpoint_restore_;
+  int64_t txn_lock_timeout_;
+  bool txn_deadlock_detect_;
+  int txn_max_retries_;
+};
+
+} // ycsbc
+
+#endif // YCSB_C_ROCKSDB_OPTIONS_H_
@@ -0,0 +1,353 @@
+//
+//  rocksdb_sharded_db.cc
+//  YCSB-C
+//
+
+#include "db/rocksdb_sharded_db.h"
+
+#include "core/utils.h"
+#include "db/record_codec.h"
+#include "rocksdb-cloud/include/rocksdb/env.h"
+
+namespace ycsbc {
+
+///
+/// Writes the records of a client into one file per shard. The keys of a
+/// shard come in the order of the client's keys, hence sorted.
+///
+class RocksdbShardedDB::ShardedFileWriter : public RecordFileWriter {
+ public:
+  ShardedFileWriter(RocksdbShardedDB *db, const std::string &table) : db_(db) {
+    for (const auto &shard : db->shards_)
+      writers_.emplace_back(shard->NewFileWriter(table));
+  }
+
+  int Add(const Slice &key, const std::vector<SliceDB::SliceKVPair> &values) {
+    return writers_[db_->shard_index(key.data(), key.size())]->Add(key, values);
+  }
+
+  int Finish() {
+    int res = DB::kOK;
+    for (const auto &writer : writers_) {
+      int s = writer->Finish();
+      if (res == DB::kOK)
+        res = s;
+    }
+    return res;
+  }
+
+ private:
+  RocksdbShardedDB *db_;
+  std::vector<std::unique_ptr<RecordFileWriter>> writers_;
+};
+
+template <typename Visit>
+int RocksdbShardedDB::MergeScan(const std::string &table, const Slice &key,
+                                int len, Visit visit) {
+  std::vector<std::unique_ptr<rocksdb::Iterator>> owned(shards_.size());
+  std::vector<rocksdb::Iterator*> its;
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    rocksdb::Iterator* it = shards_[i]->GetScanIterator(table, &owned[i]);
+    if (it == nullptr)
+      return DB::kError;
+    it->Seek(rocksdb::Slice(key.data(), key.size()));
+    if (it->Valid())
+      its.push_back(it);
+    else if (!it->status().ok())
+      return DB::kError;
+  }
+  // There are few shards, so the next record is found by comparing the
+  // current key of every shard rather than with a heap.
+  for (int iterations = 0; iterations < len && !its.empty(); iterations++) {
+    size_t next = 0;
+    for (size_t i = 1; i < its.size(); ++i) {
+      if (its[i]->key().compare(its[next]->key()) < 0)
+        next = i;
+    }
+    rocksdb::Iterator* it = its[next];
+    if (!visit(it->value()))
+      return DB::kError;
+    it->Next();
+    if (!it->Valid()) {
+      if (!it->status().ok())
+        return DB::kError;
+      its.erase(its.begin() + next);
+    }
+  }
+  return DB::kOK;
+}
+
+RocksdbShardedDB::RocksdbShardedDB(const RocksdbOptions &options) :
+    stats_(options.stats()), sim_caches_(options.sim_caches()), blob_(options.blob()) {
+  // RocksDB only creates the last directory of a path.
+  rocksdb::Status s = rocksdb::Env::Default()->CreateDirIfMissing(options.path());
+  if (!s.ok()) {
+    printf("cannot create %s: %s\n", options.path().c_str(), s.ToString().c_str());
+    exit(-1);
+  }
+  for (int i = 0; i < options.shards(); i++)
+    shards_.emplace_back(new RocksdbDB(options.ForShard(i)));
+}
+
+void RocksdbShardedDB::Close() {
+  for (const auto &shard : shards_)
+    shard->Close();
+}
+
+int RocksdbShardedDB::Read(const std::string &table, const std::string &key,
+                           const std::vector<std::string> *fields,
+                           std::vector<KVPair> &result) {
+  return shard(key)->Read(table, key, fields, result);
+}
+
+int RocksdbShardedDB::MultiRead(const std::string &table,
+                                const std::vector<std::string> &keys,
+                                const std::vector<std::string> *fields,
+                                std::vector<std::vector<KVPair>> &results,
+                                std::vector<int> &statuses) {
+  thread_local std::vector<std::vector<size_t>> index;
+  thread_local std::vector<std::string> part_keys;
+  thread_local std::vector<std::vector<KVPair>> part_results;
+  thread_local std::vector<int> part_statuses;
+  index.resize(shards_.size());
+  for (auto &i : index)
+    i.clear();
+  for (size_t i = 0; i < keys.size(); ++i)
+    index[shard_index(keys[i].data(), keys[i].size())].push_back(i);
+
+  results.assign(keys.size(), std::vector<KVPair>());
+  statuses.resize(keys.size());
+  for (size_t s = 0; s < shards_.size(); ++s) {
+    if (index[s].empty())
+      continue;
+    part_keys.clear();
+    for (size_t i : index[s])
+      part_keys.push_back(keys[i]);
+    part_statuses.clear();
+    int res = shards_[s]->MultiRead(table, part_keys, fields, part_results, part_statuses);
+    // A shard that fails as a whole leaves no status per key.
+    part_statuses.resize(part_keys.size(), res);
+    part_results.resize(part_keys.size());
+    for (size_t j = 0; j < index[s].size(); ++j) {
+      results[index[s][j]].swap(part_results[j]);
+      statuses[index[s][j]] = part_statuses[j];
+    }
+  }
+
+  for (int s : statuses) {
+    if (s != DB::kOK)
+      return s;
+  }
+  return DB::kOK;
+}
+
+int RocksdbShardedDB::Scan(const std::string &table, const std::string &key,
+                           int len, const std::vector<std::string> *fields,
+                           std::vector<std::vector<KVPair>> &result) {
+  return MergeScan(table, Slice(key), len, [&](const rocksdb::Slice &value) {
+    std::vector<KVPair> r;
+    if (!DecodeFields(value.data(), value.size(), fields, [&r](const Slice& f, const Slice& v) {
+          r.emplace_back(f.ToString(), v.ToString());
+        }))
+      return false;
+    result.push_back(std::move(r));
+    return true;
+  });
+}
+
+int RocksdbShardedDB::Update(const std::string &table, const std::string &key,
+                             std::vector<KVPair> &values) {
+  return shard(key)->Update(table, key, values);
+}
+
+int RocksdbShardedDB::Insert(const std::string &table, const std::string &key,
+                             std::vector<KVPair> &values) {
+  return shard(key)->Insert(table, key, values);
+}
+
+int RocksdbShardedDB::BatchInsert(const std::string &table,
+                                  const std::vector<std::string> &keys,
+                                  std::vector<std::vector<KVPair>> &values) {
+  thread_local std::vector<std::vector<size_t>> index;
+  thread_local std::vector<std::string> part_keys;
+  thread_local std::vector<std::vector<KVPair>> part_values;
+  index.resize(shards_.size());
+  for (auto &i : index)
+    i.clear();
+  for (size_t i = 0; i < keys.size(); ++i)
+    index[shard_index(keys[i].data(), keys[i].size())].push_back(i);
+
+  int res = DB::kOK;
+  for (size_t s = 0; s < shards_.size(); ++s) {
+    if (index[s].empty())
+      continue;
+    part_keys.clear();
+    part_values.resize(index[s].size());
+    // The values are lent to the part and given back, not copied.
+    for (size_t j = 0; j < index[s].size(); ++j) {
+      part_keys.push_back(keys[index[s][j]]);
+      part_values[j].swap(values[index[s][j]]);
+    }
+    int r = shards_[s]->BatchInsert(table, part_keys, part_values);
+    for (size_t j = 0; j < index[s].size(); ++j)
+      part_values[j].swap(values[index[s][j]]);
+    if (res == DB::kOK)
+      res = r;
+  }
+  return res;
+}
+
+int RocksdbShardedDB::Delete(const std::string &table, const std::string &key) {
+  return shard(key)->Delete(table, key);
+}
+
+int RocksdbShardedDB::Read(const std::string &table, const Slice &key,
+                           const std::vector<Slice> *fields, ResultBuffer &result) {
+  return shard(key)->Read(table, key, fields, result);
+}
+
+int RocksdbShardedDB::MultiRead(const std::string &table, const std::vector<Slice> &keys,
+                                const std::vector<Slice> *fields, ResultBuffer &result,
+                                std::vector<int> &statuses) {
+  thread_local std::vector<std::vector<size_t>> index;
+  thread_local std::vector<Slice> part_keys;
+  thread_local std::vector<ResultBuffer> part_results;
+  thread_local std::vector<int> part_statuses;
+  // Where the record of each key is: its shard and its place in the part.
+  thread_local std::vector<std::pair<size_t, size_t>> places;
+  index.resize(shards_.size());
+  part_results.resize(shards_.size());
+  for (auto &i : index)
+    i.clear();
+  places.resize(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    size_t s = shard_index(keys[i].data(), keys[i].size());
+    places[i] = std::make_pair(s, index[s].size());
+    index[s].push_back(i);
+  }
+
+  statuses.resize(keys.size());
+  for (size_t s = 0; s < shards_.size(); ++s) {
+    part_results[s].Clear();
+    if (index[s].empty())
+      continue;
+    part_keys.clear();
+    for (size_t i : index[s])
+      part_keys.push_back(keys[i]);
+    part_statuses.clear();
+    int res = shards_[s]->MultiRead(table, part_keys, fields, part_results[s], part_statuses);
+    // A shard that fails as a whole leaves no status per key.
+    part_statuses.resize(part_keys.size(), res);
+    for (size_t j = 0; j < index[s].size(); ++j)
+      statuses[index[s][j]] = part_statuses[j];
+  }
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    const ResultBuffer &part = part_results[places[i].first];
+    size_t r = places[i].second;
+    if (r < part.num_records()) {
+      for (size_t f = part.record_begin(r); f < part.record_end(r); ++f)
+        result.Append(part.field(f), part.value(f));
+    }
+    result.EndRecord();
+  }
+
+  for (int s : statuses) {
+    if (s != DB::kOK)
+      return s;
+  }
+  return DB::kOK;
+}
+
+int RocksdbShardedDB::Scan(const std::string &table, const Slice &key,
+                           int len, const std::vector<Slice> *fields, ResultBuffer &result) {
+  return StreamScan(table, key, len, fields, result);
+}
+
+int RocksdbShardedDB::StreamScan(const std::string &table, const Slice &key,
+                                 int len, const std::vector<Slice> *fields,
+                                 ScanVisitor &visitor) {
+  return MergeScan(table, key, len, [&](const rocksdb::Slice &value) {
+    if (!DecodeFields(value.data(), value.size(), fields, [&](const Slice& f, const Slice& v) {
+          visitor.Field(f, v);
+        }))
+      return false;
+    visitor.EndRecord();
+    return true;
+  });
+}
+
+int RocksdbShardedDB::Update(const std::string &table, const Slice &key,
+                             const std::vector<SliceKVPair> &values) {
+  return shard(key)->Update(table, key, values);
+}
+
+int RocksdbShardedDB::Insert(const std::string &table, const Slice &key,
+                             const std::vector<SliceKVPair> &values) {
+  return shard(key)->Insert(table, key, values);
+}
+
+int RocksdbShardedDB::Delete(const std::string &table, const Slice &key) {
+  return shard(key)->Delete(table, key);
+}
+
+RecordFileWriter *RocksdbShardedDB::NewFileWriter(const std::string &table) {
+  return new ShardedFileWriter(this, table);
+}
+
+int RocksdbShardedDB::IngestFiles(const std::string &table) {
+  int res = DB::kOK;
+  for (const auto &shard : shards_) {
+    int s = shard->IngestFiles(table);
+    if (res == DB::kOK)
+      res = s;
+  }
+  return res;
+}
+
+int RocksdbShardedDB::SaveCheckpoint(const std::string &dir) {
+  rocksdb::Status s = rocksdb::Env::Default()->CreateDirIfMissing(dir);
+  if (!s.ok()) {
+    printf("cannot create %s: %s\n", dir.c_str(), s.ToString().c_str());
+    return DB::kError;
+  }
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    int res = shards_[i]->SaveCheckpoint(RocksdbOptions::ShardPath(dir, i));
+    if (res != DB::kOK)
+      return res;
+  }
+  return DB::kOK;
+}
+
+void RocksdbShardedDB::ExportStats(MeasurementsExporter *exporter) {
+  if (stats_)
+    stats_->Export(exporter);
+  if (sim_caches_)
+    sim_caches_->Export(exporter);
+  if (blob_) {
+    uint64_t files = 0, bytes = 0;
+    for (const auto &shard : shards_)
+      shard->AddBlobFiles(&files, &bytes);
+    exporter->write("ROCKSDB-BLOB", "BlobFiles", files);
+    exporter->write("ROCKSDB-BLOB", "BlobFileBytes", bytes);
+  }
+}
+
+void RocksdbShardedDB::ResetStats() {
+  if (stats_)
+    stats_->Reset();
+  if (sim_caches_)
+    sim_caches_->Reset();
+}
+
+size_t RocksdbShardedDB::shard_index(const char *key, size_t size) const {
+  // FNV-1a, so that keys which only differ in their last bytes spread too.
+  uint64_t hash = utils::kFNVOffsetBasis64;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= (uint8_t)key[i];
+    hash *= utils::kFNVPrime64;
+  }
+  return hash % shards_.size();
+}
+
+} // namespace ycsbc
@@ -0,0 +1,129 @@
+//
+//  rocksdb_sharded_db.h
+//  YCSB-C
+//
+
+#ifndef YCSB_C_ROCKSDB_SHARDED_DB_H_
+#define YCSB_C_ROCKSDB_SHARDED_DB_H_
+
+#include "core/db.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "db/rocksdb_db.h"
+#include "db/rocksdb_options.h"
+
+namespace ycsbc {
+
+///
+/// Partitions the keys over rocksdb.shards independently opened RocksdbDBs
+/// by a hash of the key, the way a host runs several instances, so writes
+/// are not serialized on one write-ahead log and memtable. Each shard is in
+/// a subdirectory of rocksdb.dir (see RocksdbOptions::ForShard()). Scans
+/// merge the shards in key order.
+///
+class RocksdbShardedDB : public DB, public SliceDB, public IngestDB {
+ public:
+  RocksdbShardedDB(const RocksdbOptions &options);
+
+  void Close();
+
+  int Read(const std::string &table, const std::string &key,
+           const std::vector<std::string> *fields,
+           std::vector<KVPair> &result);
+
+  /// Splits the keys by shard and reads each part with one MultiRead.
+  int MultiRead(const std::string &table, const std::vector<std::string> &keys,
+                const std::vector<std::string> *fields,
+                std::vector<std::vector<KVPair>> &results,
+                std::vector<int> &statuses);
+
+  int Scan(const std::string &table, const std::string &key,
+           int len, const std::vector<std::string> *fields,
+           std::vector<std::vector<KVPair>> &result);
+
+  int Update(const std::string &table, const std::string &key,
+             std::vector<KVPair> &values);
+
+  int Insert(const std::string &table, const std::string &key,
+             std::vector<KVPair> &values);
+
+  /// Splits the records by shard and writes each part with one WriteBatch.
+  int BatchInsert(const std::string &table, const std::vector<std::string> &keys,
+                  std::vector<std::vector<KVPair>> &values);
+
+  int Delete(const std::string &table, const std::string &key);
+
+  SliceDB *GetSliceDB() { return this; }
+
+  int Read(const std::string &table, const Slice &key,
+           const std::vector<Slice> *fields, ResultBuffer &result);
+
+  ///
+  /// Splits the keys by shard, reads each part with one MultiRead and
+  /// appends the records to result in the order of keys.
+  ///
+  int MultiRead(const std::string &table, const std::vector<Slice> &keys,
+                const std::vector<Slice> *fields, ResultBuffer &result,
+                std::vector<int> &statuses);
+
+  int Scan(const std::string &table, const Slice &key,
+           int len, const std::vector<Slice> *fields, ResultBuffer &result);
+
+  int StreamScan(const std::string &table, const Slice &key,
+                 int len, const std::vector<Slice> *fields, ScanVisitor &visitor);
+
+  int Update(const std::string &table, const Slice &key,
+             const std::vector<SliceKVPair> &values);
+
+  int Insert(const std::string &table, const Slice &key,
+             const std::vector<SliceKVPair> &values);
+
+  int Delete(const std::string &table, const Slice &key);
+
+  IngestDB *GetIngestDB() { return this; }
+
+  /// Writes one SST file per shard.
+  RecordFileWriter *NewFileWriter(const std::string &table);
+
+  int IngestFiles(const std::string &table);
+
+  /// Writes the checkpoint of each shard to its subdirectory of dir.
+  int SaveCheckpoint(const std::string &dir);
+
+  ///
+  /// The shards share their statistics and simulated caches, which are
+  /// written once; the blob files of a BlobDB are counted over all shards.
+  ///
+  void ExportStats(MeasurementsExporter *exporter);
+
+  void ResetStats();
+
+ private:
+  class ShardedFileWriter;
+
+  size_t shard_index(const char *key, size_t size) const;
+  RocksdbDB *shard(const std::string &key) const {
+    return shards_[shard_index(key.data(), key.size())].get();
+  }
+  RocksdbDB *shard(const Slice &key) const {
+    return shards_[shard_index(key.data(), key.size())].get();
+  }
+
+  // Calls visit(value) for the values of the first len records of table
+  // from key on, in key order over all shards. visit returns false if the
+  // value cannot be decoded.
+  template <typename Visit>
+  int MergeScan(const std::string &table, const Slice &key, int len, Visit visit);
+
+  std::vector<std::unique_ptr<RocksdbDB>> shards_;
+  std::shared_ptr<RocksdbStats> stats_; // NULL without rocksdb.statistics
+  std::shared_ptr<SimCacheCurve> sim_caches_;
+  bool blob_;
+};
+
+} // ycsbc
+
+#endif // YCSB_C_ROCKSDB_SHARDED_DB_H_
@@ -0,0 +1,49 @@
+//
+//  rocksdb_sim_cache.cc
+//  YCSB-C
+//
+
+#include "db/rocksdb_sim_cache.h"
+
+namespace ycsbc {
+
+std::shared_ptr<rocksdb::Cache> SimCacheCurve::Wrap(const std::shared_ptr<rocksdb::Cache> &cache,
+                                                    int parts) {
+  std::vector<std::shared_ptr<rocksdb::SimCache>> chain;
+  std::shared_ptr<rocksdb::Cache> outer = cache;
+  // Every SimCache passes lookups and inserts on to the one it wraps, so
+  // each sees all of them.
+  for (const Size &size : sizes_) {
+    chain.push_back(rocksdb::NewSimCache(outer, size.capacity / parts, -1));
+    outer = chain.back();
+  }
+  MutexLock lock(&lock_);
+  chains_.push_back(std::move(chain));
+  return outer;
+}
+
+void SimCacheCurve::Reset() {
+  MutexLock lock(&lock_);
+  for (const auto &chain : chains_) {
+    for (const auto &sim_cache : chain)
+      sim_cache->reset_counter();
+  }
+}
+
+void SimCacheCurve::Export(MeasurementsExporter *exporter) {
+  MutexLock lock(&lock_);
+  for (size_t i = 0; i < sizes_.size(); ++i) {
+    uint64_t hits = 0, misses = 0;
+    for (const auto &chain : chains_) {
+      hits += chain[i]->get_hit_counter();
+      misses += chain[i]->get_miss_counter();
+    }
+    if (i == 0)
+      exporter->write("ROCKSDB-SIMCACHE", "Lookups", hits + misses);
+    if (hits + misses > 0)
+      exporter->write("ROCKSDB-SIMCACHE", "HitRatio-" + sizes_[i].name,
+                      (double)hits / (hits + misses));
+  }
+}
+
+} // ycsbc
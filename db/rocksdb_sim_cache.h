@@ -0,0 +1,71 @@
+//
+//  rocksdb_sim_cache.h
+//  YCSB-C
+//
+
+#ifndef YCSB_C_ROCKSDB_SIM_CACHE_H_
+#define YCSB_C_ROCKSDB_SIM_CACHE_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/measurements.h"
+#include "lib/mutexlock.h"
+#include "rocksdb-cloud/include/rocksdb/cache.h"
+#include "rocksdb-cloud/include/rocksdb/utilities/sim_cache.h"
+
+namespace ycsbc {
+
+///
+/// Simulates block caches of several sizes in one run: the real block
+/// cache is wrapped in a chain of rocksdb::SimCaches, one per size, which
+/// each keep the keys (not the blocks) a cache of that size would hold and
+/// count its hits and misses.
+///
+/// The blocks a SimCache sees inserted are those the real cache misses, so
+/// only sizes of at least the real cache are simulated faithfully.
+///
+class SimCacheCurve {
+ public:
+  ///
+  /// A size to simulate, named by how it was configured (e.g. "4G").
+  ///
+  struct Size {
+    std::string name;
+    size_t capacity;
+  };
+
+  explicit SimCacheCurve(const std::vector<Size> &sizes) : sizes_(sizes) {}
+
+  ///
+  /// Returns cache wrapped in SimCaches of the sizes divided by parts, for
+  /// a real cache that is one of parts equal ones (one per shard); the
+  /// hits and misses of all the caches wrapped are summed.
+  ///
+  std::shared_ptr<rocksdb::Cache> Wrap(const std::shared_ptr<rocksdb::Cache> &cache,
+                                       int parts = 1);
+
+  ///
+  /// Writes the simulated hit ratio of each size as metric ROCKSDB-SIMCACHE,
+  /// e.g. HitRatio-4G, along with the number of Lookups.
+  ///
+  void Export(MeasurementsExporter *exporter);
+
+  ///
+  /// Leaves the lookups so far out of later exports, e.g. those of a
+  /// warm-up phase. The simulated caches keep their contents.
+  ///
+  void Reset();
+
+ private:
+  std::vector<Size> sizes_;
+  Mutex lock_;
+  // The SimCaches of each cache wrapped, in the order of sizes_.
+  std::vector<std::vector<std::shared_ptr<rocksdb::SimCache>>> chains_;
+};
+
+} // ycsbc
+
+#endif // YCSB_C_ROCKSDB_SIM_CACHE_H_
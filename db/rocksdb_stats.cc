@@ -0,0 +1,196 @@
+//
+//  rocksdb_stats.cc
+//  YCSB-C
+//
+
+#include "db/rocksdb_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include "rocksdb-cloud/include/rocksdb/iostats_context.h"
+#include "rocksdb-cloud/include/rocksdb/perf_context.h"
+
+using std::string;
+using ycsbc::RocksdbStats;
+
+namespace {
+
+const char *const kKindMetrics[RocksdbStats::kNumKinds] = {
+  "ROCKSDB-READ",
+  "ROCKSDB-SCAN",
+  "ROCKSDB-WRITE"
+};
+
+// Tickers exported as they are.
+const struct {
+  rocksdb::Tickers ticker;
+  const char *name;
+} kTickers[] = {
+  { rocksdb::BLOCK_CACHE_HIT, "BlockCacheHits" },
+  { rocksdb::BLOCK_CACHE_MISS, "BlockCacheMisses" },
+  { rocksdb::BLOOM_FILTER_USEFUL, "BloomFilterUseful" },
+  { rocksdb::MEMTABLE_HIT, "MemtableHits" },
+  { rocksdb::MEMTABLE_MISS, "MemtableMisses" },
+  { rocksdb::GET_HIT_L0, "GetHitsL0" },
+  { rocksdb::GET_HIT_L1, "GetHitsL1" },
+  { rocksdb::GET_HIT_L2_AND_UP, "GetHitsL2AndUp" },
+  { rocksdb::NUMBER_KEYS_READ, "KeysRead" },
+  { rocksdb::BYTES_READ, "BytesRead" },
+  { rocksdb::BYTES_WRITTEN, "BytesWritten" },
+  { rocksdb::WAL_FILE_BYTES, "WalFileBytes" },
+  { rocksdb::FLUSH_WRITE_BYTES, "FlushWriteBytes" },
+  { rocksdb::COMPACT_READ_BYTES, "CompactReadBytes" },
+  { rocksdb::COMPACT_WRITE_BYTES, "CompactWriteBytes" },
+  { rocksdb::STALL_MICROS, "StallMicros" }
+};
+
+// Tickers of BlobDB, exported as they are.
+const struct {
+  rocksdb::Tickers ticker;
+  const char *name;
+} kBlobTickers[] = {
+  { rocksdb::BLOB_DB_WRITE_BLOB, "BlobWrites" },
+  { rocksdb::BLOB_DB_WRITE_INLINED, "InlinedWrites" },
+  { rocksdb::BLOB_DB_BLOB_FILE_BYTES_WRITTEN, "BlobFileBytesWritten" },
+  { rocksdb::BLOB_DB_BLOB_FILE_BYTES_READ, "BlobFileBytesRead" },
+  { rocksdb::BLOB_DB_GC_NUM_FILES, "GcFiles" },
+  { rocksdb::BLOB_DB_GC_NUM_NEW_FILES, "GcNewFiles" },
+  { rocksdb::BLOB_DB_GC_BYTES_RELOCATED, "GcBytesRelocated" },
+  { rocksdb::BLOB_DB_GC_BYTES_OVERWRITTEN, "GcBytesOverwritten" },
+  { rocksdb::BLOB_DB_FIFO_NUM_FILES_EVICTED, "FifoFilesEvicted" },
+  { rocksdb::BLOB_DB_FIFO_BYTES_EVICTED, "FifoBytesEvicted" }
+};
+
+// Names of the per key averages of the sampled counters, from
+// kBlockCacheHits on.
+const char *const kCounterNames[] = {
+  "BlockCacheHitsPerKey",
+  "BlockReadsPerKey",
+  "BlockReadBytesPerKey",
+  "MemtableNanosPerKey",
+  "SstNanosPerKey",
+  "WriteWalNanosPerKey",
+  "WriteMemtableNanosPerKey",
+  "WriteDelayNanosPerKey",
+  "IoBytesReadPerKey",
+  "IoBytesWrittenPerKey",
+  "IoReadNanosPerKey"
+};
+
+} // namespace
+
+RocksdbStats::Sample::Sample(RocksdbStats *stats, Kind kind, size_t keys) :
+    stats_(NULL), kind_(kind), keys_(keys), level_(rocksdb::kDisable) {
+  if (stats == NULL || !stats->ShouldSample())
+    return;
+  stats_ = stats;
+  level_ = rocksdb::GetPerfLevel();
+  rocksdb::SetPerfLevel(rocksdb::kEnableTimeExceptForMutex);
+  rocksdb::get_perf_context()->Reset();
+  rocksdb::get_iostats_context()->Reset();
+}
+
+RocksdbStats::Sample::~Sample() {
+  if (stats_ == NULL)
+    return;
+  stats_->Record(kind_, keys_);
+  rocksdb::SetPerfLevel(level_);
+}
+
+RocksdbStats::RocksdbStats(const std::shared_ptr<rocksdb::Statistics> &statistics,
+                           double sample_rate, bool blob) :
+    statistics_(statistics), sample_every_(0), blob_(blob),
+    ticker_base_(rocksdb::TICKER_ENUM_MAX, 0), counter_base_() {
+  if (sample_rate > 0)
+    sample_every_ = std::max((uint64_t)1, (uint64_t)std::llround(1 / sample_rate));
+}
+
+bool RocksdbStats::ShouldSample() {
+  if (sample_every_ == 0)
+    return false;
+  thread_local uint64_t operations = 0;
+  return operations++ % sample_every_ == 0;
+}
+
+void RocksdbStats::Record(Kind kind, size_t keys) {
+  Shard *shard = shards_.local([]() { return new Shard(); });
+  std::atomic<uint64_t> *c = shard->counters[kind];
+  const rocksdb::PerfContext *perf = rocksdb::get_perf_context();
+  const rocksdb::IOStatsContext *io = rocksdb::get_iostats_context();
+  add_relaxed(c[kSamples], (uint64_t)1);
+  add_relaxed(c[kKeys], (uint64_t)keys);
+  add_relaxed(c[kBlockCacheHits], perf->block_cache_hit_count);
+  add_relaxed(c[kBlockReads], perf->block_read_count);
+  add_relaxed(c[kBlockReadBytes], perf->block_read_byte);
+  add_relaxed(c[kMemtableNanos], perf->get_from_memtable_time + perf->seek_on_memtable_time);
+  add_relaxed(c[kSstNanos], perf->get_from_output_files_time);
+  add_relaxed(c[kWriteWalNanos], perf->write_wal_time);
+  add_relaxed(c[kWriteMemtableNanos], perf->write_memtable_time);
+  add_relaxed(c[kWriteDelayNanos], perf->write_delay_time);
+  add_relaxed(c[kIoBytesRead], io->bytes_read);
+  add_relaxed(c[kIoBytesWritten], io->bytes_written);
+  add_relaxed(c[kIoReadNanos], io->read_nanos);
+}
+
+uint64_t RocksdbStats::Ticker(rocksdb::Tickers ticker) {
+  return statistics_->getTickerCount(ticker) - ticker_base_[ticker];
+}
+
+void RocksdbStats::SumCounters(uint64_t sums[kNumKinds][kNumCounters]) {
+  shards_.for_each([sums](Shard *shard) {
+    for (int k = 0; k < kNumKinds; k++) {
+      for (int c = 0; c < kNumCounters; c++)
+        sums[k][c] += shard->counters[k][c].load(std::memory_order_relaxed);
+    }
+  });
+}
+
+void RocksdbStats::Reset() {
+  std::lock_guard<std::mutex> lock(reset_mutex_);
+  if (statistics_) {
+    for (uint32_t t = 0; t < rocksdb::TICKER_ENUM_MAX; t++)
+      ticker_base_[t] = statistics_->getTickerCount(t);
+  }
+  for (int k = 0; k < kNumKinds; k++) {
+    for (int c = 0; c < kNumCounters; c++)
+      counter_base_[k][c] = 0;
+  }
+  SumCounters(counter_base_);
+}
+
+void RocksdbStats::Export(MeasurementsExporter *exporter) {
+  std::lock_guard<std::mutex> lock(reset_mutex_);
+  if (statistics_) {
+    for (const auto &t : kTickers)
+      exporter->write("ROCKSDB", t.name, Ticker(t.ticker));
+    uint64_t hits = Ticker(rocksdb::BLOCK_CACHE_HIT);
+    uint64_t misses = Ticker(rocksdb::BLOCK_CACHE_MISS);
+    if (hits + misses > 0)
+      exporter->write("ROCKSDB", "BlockCacheHitRatio", (double)hits / (hits + misses));
+    uint64_t keys = Ticker(rocksdb::NUMBER_KEYS_READ);
+    if (keys > 0)
+      exporter->write("ROCKSDB", "BytesReadPerGet", (double)Ticker(rocksdb::BYTES_READ) / keys);
+    if (blob_) {
+      for (const auto &t : kBlobTickers)
+        exporter->write("ROCKSDB-BLOB", t.name, Ticker(t.ticker));
+    }
+  }
+
+  uint64_t sums[kNumKinds][kNumCounters] = {};
+  SumCounters(sums);
+  for (int k = 0; k < kNumKinds; k++) {
+    for (int c = 0; c < kNumCounters; c++)
+      sums[k][c] -= counter_base_[k][c];
+  }
+  for (int k = 0; k < kNumKinds; k++) {
+    if (sums[k][kKeys] == 0)
+      continue;
+    exporter->write(kKindMetrics[k], "Samples", sums[k][kSamples]);
+    exporter->write(kKindMetrics[k], "SampledKeys", sums[k][kKeys]);
+    for (int c = kBlockCacheHits; c < kNumCounters; c++) {
+      exporter->write(kKindMetrics[k], kCounterNames[c - kBlockCacheHits],
+                      (double)sums[k][c] / sums[k][kKeys]);
+    }
+  }
+}
@@ -0,0 +1,135 @@
+//
+//  rocksdb_stats.h
+//  YCSB-C
+//
+
+#ifndef YCSB_C_ROCKSDB_STATS_H_
+#define YCSB_C_ROCKSDB_STATS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "core/measurements.h"
+#include "rocksdb-cloud/include/rocksdb/perf_level.h"
+#include "rocksdb-cloud/include/rocksdb/statistics.h"
+
+namespace ycsbc {
+
+///
+/// Statistics of a RocksDB instance: the tickers of rocksdb::Statistics,
+/// and the PerfContext and IOStatsContext of a sample of the operations.
+/// The counters of sampled operations are kept per thread and summed when
+/// exported.
+///
+class RocksdbStats {
+ public:
+  ///
+  /// The kinds of operations samples are reported under.
+  ///
+  enum Kind {
+    kRead,  // Get and MultiGet
+    kScan,
+    kWrite, // including the Get of a read-modify-write update
+    kNumKinds
+  };
+
+  ///
+  /// Samples the operation in its scope, if it is one of the sampled ones.
+  ///
+  class Sample {
+   public:
+    ///
+    /// @param stats The statistics to report to, or NULL for none.
+    /// @param kind The kind of the operation.
+    /// @param keys The number of keys the operation reads or writes.
+    ///
+    Sample(RocksdbStats *stats, Kind kind, size_t keys = 1);
+    ~Sample();
+
+    Sample(const Sample&) = delete;
+    void operator=(const Sample&) = delete;
+
+   private:
+    RocksdbStats *stats_;
+    Kind kind_;
+    size_t keys_;
+    rocksdb::PerfLevel level_;
+  };
+
+  ///
+  /// @param statistics The statistics of the DB, or NULL if it has none.
+  /// @param sample_rate The fraction of the operations to sample, between
+  ///        0 and 1. Every thread samples every (1/sample_rate)-th of its
+  ///        operations.
+  /// @param blob Whether the DB is a BlobDB, whose tickers are reported too.
+  ///
+  RocksdbStats(const std::shared_ptr<rocksdb::Statistics> &statistics,
+               double sample_rate, bool blob = false);
+
+  ///
+  /// Writes the tickers as metric ROCKSDB (and ROCKSDB-BLOB for a BlobDB),
+  /// and the averages per key of the samples of each kind as metrics
+  /// ROCKSDB-READ, ROCKSDB-SCAN and ROCKSDB-WRITE, all counted since the
+  /// last Reset(), if any.
+  ///
+  void Export(MeasurementsExporter *exporter);
+
+  ///
+  /// Leaves what was counted so far out of later exports, e.g. the
+  /// operations of a warm-up phase.
+  ///
+  void Reset();
+
+ private:
+  enum Counter {
+    kSamples,
+    kKeys,
+    kBlockCacheHits,
+    kBlockReads,
+    kBlockReadBytes,
+    kMemtableNanos,
+    kSstNanos,
+    kWriteWalNanos,
+    kWriteMemtableNanos,
+    kWriteDelayNanos,
+    kIoBytesRead,
+    kIoBytesWritten,
+    kIoReadNanos,
+    kNumCounters
+  };
+
+  struct Shard {
+    Shard() {
+      for (int k = 0; k < kNumKinds; k++) {
+        for (int c = 0; c < kNumCounters; c++)
+          counters[k][c].store(0, std::memory_order_relaxed);
+      }
+    }
+    std::atomic<uint64_t> counters[kNumKinds][kNumCounters];
+  };
+
+  // Whether the calling thread samples its next operation.
+  bool ShouldSample();
+  // Adds the contexts of the calling thread to its shard.
+  void Record(Kind kind, size_t keys);
+  // The count of ticker since the last Reset(). Callers hold reset_mutex_.
+  uint64_t Ticker(rocksdb::Tickers ticker);
+  // Sums the counters of the shards.
+  void SumCounters(uint64_t sums[kNumKinds][kNumCounters]);
+
+  std::shared_ptr<rocksdb::Statistics> statistics_;
+  uint64_t sample_every_; // 0 if nothing is sampled
+  bool blob_;
+  ThreadShards<Shard> shards_;
+  // The counts at the last Reset(), which exports subtract.
+  std::mutex reset_mutex_;
+  std::vector<uint64_t> ticker_base_;
+  uint64_t counter_base_[kNumKinds][kNumCounters];
+};
+
+} // ycsbc
+
+#endif // YCSB_C_ROCKSDB_STATS_H_
@@ -0,0 +1,119 @@
+//
+//  rocksdb_timeline.cc
+//  YCSB-C
+//
+
+#include "db/rocksdb_timeline.h"
+
+#include "core/timer.h"
+#include "core/utils.h"
+#include "rocksdb-cloud/include/rocksdb/metadata.h"
+
+using std::string;
+using std::to_string;
+using ycsbc::TimelineListener;
+
+namespace {
+
+const char *StallConditionName(rocksdb::WriteStallCondition c) {
+  switch (c) {
+    case rocksdb::WriteStallCondition::kNormal: return "normal";
+    case rocksdb::WriteStallCondition::kDelayed: return "delayed";
+    case rocksdb::WriteStallCondition::kStopped: return "stopped";
+  }
+  return "unknown";
+}
+
+string FlushFields(const rocksdb::FlushJobInfo &info) {
+  return ",\"job_id\":" + to_string(info.job_id) +
+      ",\"reason\":" + to_string((int)info.flush_reason);
+}
+
+string CompactionFields(const rocksdb::CompactionJobInfo &info) {
+  return ",\"job_id\":" + to_string(info.job_id) +
+      ",\"reason\":" + to_string((int)info.compaction_reason) +
+      ",\"input_level\":" + to_string(info.base_input_level) +
+      ",\"output_level\":" + to_string(info.output_level) +
+      ",\"input_files\":" + to_string(info.input_files.size());
+}
+
+} // namespace
+
+TimelineListener::TimelineListener(const string &path) {
+  file_.open(path);
+  if (!file_.is_open())
+    throw utils::Exception("Failed to open timeline file: " + path);
+}
+
+void TimelineListener::Attach(rocksdb::DB *db, const ColumnFamilyRegistry *column_families) {
+  MutexLock lock(&mutex_);
+  dbs_.emplace_back(db, column_families);
+}
+
+void TimelineListener::Detach(rocksdb::DB *db) {
+  MutexLock lock(&mutex_);
+  for (size_t i = 0; i < dbs_.size(); i++) {
+    if (dbs_[i].first == db) {
+      dbs_.erase(dbs_.begin() + i);
+      return;
+    }
+  }
+}
+
+void TimelineListener::OnFlushBegin(rocksdb::DB *db, const rocksdb::FlushJobInfo &info) {
+  Write("flush_begin", db, info.cf_name, FlushFields(info));
+}
+
+void TimelineListener::OnFlushCompleted(rocksdb::DB *db, const rocksdb::FlushJobInfo &info) {
+  Write("flush_end", db, info.cf_name, FlushFields(info) +
+      ",\"bytes\":" + to_string(info.table_properties.data_size) +
+      ",\"triggered_slowdown\":" + (info.triggered_writes_slowdown ? "true" : "false") +
+      ",\"triggered_stop\":" + (info.triggered_writes_stop ? "true" : "false"));
+}
+
+void TimelineListener::OnCompactionBegin(rocksdb::DB *db,
+                                         const rocksdb::CompactionJobInfo &info) {
+  Write("compaction_begin", db, info.cf_name, CompactionFields(info));
+}
+
+void TimelineListener::OnCompactionCompleted(rocksdb::DB *db,
+                                             const rocksdb::CompactionJobInfo &info) {
+  Write("compaction_end", db, info.cf_name, CompactionFields(info) +
+      ",\"output_files\":" + to_string(info.output_files.size()) +
+      ",\"ok\":" + (info.status.ok() ? "true" : "false"));
+}
+
+void TimelineListener::OnStallConditionsChanged(const rocksdb::WriteStallInfo &info) {
+  Write("stall", nullptr, info.cf_name,
+      string(",\"condition\":\"") + StallConditionName(info.condition.cur) +
+      "\",\"previous\":\"" + StallConditionName(info.condition.prev) + "\"");
+}
+
+void TimelineListener::Write(const char *event, rocksdb::DB *db, const string &cf,
+                             const string &fields) {
+  uint64_t now_ms = utils::NowNanos() / 1000000;
+  MutexLock lock(&mutex_);
+  file_ << "{\"timestamp_ms\":" << now_ms << ",\"event\":\"" << event << "\"";
+  if (db != nullptr && dbs_.size() > 1)
+    file_ << ",\"db\":\"" << db->GetName() << "\"";
+  file_ << ",\"cf\":\"" << cf << "\"" << fields;
+
+  if (db == nullptr && dbs_.size() == 1)
+    db = dbs_[0].first;
+  rocksdb::ColumnFamilyHandle *cfh = nullptr;
+  for (const auto &d : dbs_) {
+    if (db != nullptr && d.first == db)
+      cfh = d.second->Find(cf);
+  }
+  if (cfh != nullptr) {
+    // Listeners are called without the DB mutex held, so the metadata can
+    // be read here.
+    rocksdb::ColumnFamilyMetaData meta;
+    db->GetColumnFamilyMetaData(cfh, &meta);
+    file_ << ",\"files_per_level\":[";
+    for (size_t i = 0; i < meta.levels.size(); i++)
+      file_ << (i == 0 ? "" : ",") << meta.levels[i].files.size();
+    file_ << "]";
+  }
+  file_ << "}" << std::endl;
+}
@@ -0,0 +1,71 @@
+//
+//  rocksdb_timeline.h
+//  YCSB-C
+//
+
+#ifndef YCSB_C_ROCKSDB_TIMELINE_H_
+#define YCSB_C_ROCKSDB_TIMELINE_H_
+
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "db/column_family_registry.h"
+#include "lib/mutexlock.h"
+#include "rocksdb-cloud/include/rocksdb/db.h"
+#include "rocksdb-cloud/include/rocksdb/listener.h"
+
+namespace ycsbc {
+
+///
+/// Writes the flushes, compactions and write stall changes of a DB to a
+/// file, one JSON object per line, e.g.
+///
+///   {"timestamp_ms":1571234567890,"event":"compaction_end","cf":"usertable",
+///    "job_id":12,"reason":1,"input_level":0,"output_level":1,
+///    "input_files":4,"output_files":3,"ok":true,"files_per_level":[0,9,0]}
+///
+/// Events are "flush_begin", "flush_end", "compaction_begin",
+/// "compaction_end" and "stall" (with "condition" and "previous" being
+/// "normal", "delayed" or "stopped"). Reasons are the values of
+/// rocksdb::FlushReason and rocksdb::CompactionReason. The timestamps are
+/// those of status.file, so the events line up with its intervals. When
+/// the listener serves several DBs, events of a DB also have its "db" path;
+/// stalls do not say which DB they are of, so they then have no file counts.
+///
+class TimelineListener : public rocksdb::EventListener {
+ public:
+  ///
+  /// Throws utils::Exception if the file cannot be opened.
+  ///
+  explicit TimelineListener(const std::string &path);
+
+  ///
+  /// Adds a DB the listener is registered with and its column families,
+  /// which events report the files per level of. Until then, and after
+  /// Detach(db), they are left out.
+  ///
+  void Attach(rocksdb::DB *db, const ColumnFamilyRegistry *column_families);
+  void Detach(rocksdb::DB *db);
+
+  void OnFlushBegin(rocksdb::DB *db, const rocksdb::FlushJobInfo &info) override;
+  void OnFlushCompleted(rocksdb::DB *db, const rocksdb::FlushJobInfo &info) override;
+  void OnCompactionBegin(rocksdb::DB *db, const rocksdb::CompactionJobInfo &info) override;
+  void OnCompactionCompleted(rocksdb::DB *db, const rocksdb::CompactionJobInfo &info) override;
+  void OnStallConditionsChanged(const rocksdb::WriteStallInfo &info) override;
+
+ private:
+  // Writes the line of event of cf of db (NULL if unknown), with the
+  // members in fields.
+  void Write(const char *event, rocksdb::DB *db, const std::string &cf,
+             const std::string &fields);
+
+  Mutex mutex_;
+  std::ofstream file_;
+  std::vector<std::pair<rocksdb::DB*, const ColumnFamilyRegistry*>> dbs_;
+};
+
+} // ycsbc
+
+#endif // YCSB_C_ROCKSDB_TIMELINE_H_
@@ -0,0 +1,171 @@
+//
+//  rocksdb_txn_db.cc
+//  YCSB-C
+//
+
+#include "db/rocksdb_txn_db.h"
+
+#include "core/timer.h"
+#include "db/record_codec.h"
+
+namespace ycsbc {
+
+RocksdbTxnDB::RocksdbTxnDB(const RocksdbOptions &options, Concurrency concurrency) :
+    RocksdbTxnDB(options, Open(options, concurrency)) {
+}
+
+RocksdbTxnDB::RocksdbTxnDB(const RocksdbOptions &options, const OpenDB &db) :
+    RocksdbDB(options, db.db, db.handles), txn_db_(db.txn_db), occ_db_(db.occ_db),
+    max_retries_(options.txn_max_retries()) {
+  txn_options_.lock_timeout = options.txn_lock_timeout();
+  txn_options_.deadlock_detect = options.txn_deadlock_detect();
+}
+
+RocksdbTxnDB::OpenDB RocksdbTxnDB::Open(const RocksdbOptions &options,
+                                        Concurrency concurrency) {
+  if (options.blob()) {
+    printf("cannot open rocksdb: rocksdb.blob has no transactions\n");
+    exit(-1);
+  }
+  OpenDB db = { nullptr, nullptr, nullptr, {} };
+  std::vector<rocksdb::ColumnFamilyDescriptor> column_families = options.column_families();
+  rocksdb::Status s;
+  if (concurrency == kPessimistic) {
+    rocksdb::TransactionDBOptions txn_db_options;
+    txn_db_options.transaction_lock_timeout = options.txn_lock_timeout();
+    // Writes outside of Transaction() lock their key too.
+    txn_db_options.default_lock_timeout = options.txn_lock_timeout();
+    s = rocksdb::TransactionDB::Open(options.options(), txn_db_options,
+                                     restore_checkpoint(options), column_families,
+                                     &db.handles, &db.txn_db);
+    db.db = db.txn_db;
+  } else {
+    // Validation looks up the last write of a key in the memtables; without
+    // flushed ones kept around, a key written before the last flush fails
+    // the commit with TryAgain.
+    for (rocksdb::ColumnFamilyDescriptor &cf : column_families) {
+      if (cf.options.max_write_buffer_number_to_maintain == 0 &&
+          cf.options.max_write_buffer_size_to_maintain == 0)
+        cf.options.max_write_buffer_number_to_maintain = cf.options.max_write_buffer_number;
+    }
+    s = rocksdb::OptimisticTransactionDB::Open(options.options(), restore_checkpoint(options),
+                                               column_families, &db.handles, &db.occ_db);
+    db.db = db.occ_db;
+  }
+  if (!s.ok()) {
+    printf("cannot open rocksdb: %s\n", s.ToString().c_str());
+    exit(-1);
+  }
+  return db;
+}
+
+rocksdb::Transaction *RocksdbTxnDB::Begin(rocksdb::Transaction *txn) {
+  if (txn_db_ != nullptr)
+    return txn_db_->BeginTransaction(write_options(), txn_options_, txn);
+  return occ_db_->BeginTransaction(write_options(), rocksdb::OptimisticTransactionOptions(), txn);
+}
+
+int RocksdbTxnDB::Transaction(const std::string &table, const std::vector<std::string> &keys,
+                              std::vector<std::vector<KVPair>> &values) {
+  rocksdb::ColumnFamilyHandle* cfh = get_columnfamily(table);
+  if (cfh == nullptr)
+    return DB::kError;
+  Shard *shard = shards_.local([]() { return new Shard(); });
+  std::unique_ptr<rocksdb::Transaction> txn;
+  int res = DB::kErrorConflict;
+  for (int attempt = 0; attempt <= max_retries_; attempt++) {
+    if (attempt > 0)
+      add_relaxed(shard->counters[kRetries], (uint64_t)1);
+    add_relaxed(shard->counters[kAttempts], (uint64_t)1);
+    txn.reset(Begin(txn.release()));
+    res = Attempt(txn.get(), cfh, keys, values);
+    if (res != DB::kErrorConflict)
+      break;
+    add_relaxed(shard->counters[kConflicts], (uint64_t)1);
+  }
+  if (res == DB::kOK)
+    add_relaxed(shard->counters[kCommits], (uint64_t)1);
+  else if (res == DB::kErrorConflict)
+    add_relaxed(shard->counters[kAborts], (uint64_t)1);
+  return res;
+}
+
+int RocksdbTxnDB::Attempt(rocksdb::Transaction *txn, rocksdb::ColumnFamilyHandle *cfh,
+                          const std::vector<std::string> &keys,
+                          std::vector<std::vector<KVPair>> &values) {
+  thread_local std::string old_value;
+  thread_local std::string record;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    // Busy is a write conflict or, with deadlock detection, a deadlock;
+    // TimedOut a lock wait that took too long.
+    rocksdb::Status s = txn->GetForUpdate(rocksdb::ReadOptions(), cfh, keys[i], &old_value);
+    if (s.IsBusy() || s.IsTimedOut() || s.IsTryAgain()) {
+      txn->Rollback();
+      return DB::kErrorConflict;
+    } else if (!s.ok()) {
+      txn->Rollback();
+      return s.IsNotFound() ? DB::kNotFound : DB::kError;
+    }
+    record.clear();
+    if (!PatchRecord(record_format(), old_value.data(), old_value.size(), values[i], &record)) {
+      txn->Rollback();
+      return DB::kError;
+    }
+    s = txn->Put(cfh, keys[i], record);
+    if (s.IsBusy() || s.IsTimedOut() || s.IsTryAgain()) {
+      txn->Rollback();
+      return DB::kErrorConflict;
+    } else if (!s.ok()) {
+      txn->Rollback();
+      return DB::kError;
+    }
+  }
+
+  uint64_t st = utils::NowNanos();
+  rocksdb::Status s = txn->Commit();
+  Measurements::get_measurements().measure("TRANSACTION-COMMIT", (utils::NowNanos() - st) / 1000);
+  // An optimistic transaction finds its conflicts here.
+  if (s.IsBusy() || s.IsTimedOut() || s.IsTryAgain())
+    return DB::kErrorConflict;
+  return s.ok() ? DB::kOK : DB::kError;
+}
+
+void RocksdbTxnDB::SumCounters(uint64_t sums[kNumCounters]) {
+  shards_.for_each([sums](Shard *shard) {
+    for (int c = 0; c < kNumCounters; c++)
+      sums[c] += shard->counters[c].load(std::memory_order_relaxed);
+  });
+  for (int c = 0; c < kNumCounters; c++)
+    sums[c] -= counter_base_[c];
+}
+
+void RocksdbTxnDB::ResetStats() {
+  RocksdbDB::ResetStats();
+  std::lock_guard<std::mutex> lock(reset_mutex_);
+  uint64_t sums[kNumCounters] = {};
+  SumCounters(sums);
+  for (int c = 0; c < kNumCounters; c++)
+    counter_base_[c] += sums[c];
+}
+
+void RocksdbTxnDB::ExportStats(MeasurementsExporter *exporter) {
+  RocksdbDB::ExportStats(exporter);
+  uint64_t sums[kNumCounters] = {};
+  {
+    std::lock_guard<std::mutex> lock(reset_mutex_);
+    SumCounters(sums);
+  }
+  exporter->write("TRANSACTION-ROCKSDB", "Attempts", sums[kAttempts]);
+  exporter->write("TRANSACTION-ROCKSDB", "Commits", sums[kCommits]);
+  exporter->write("TRANSACTION-ROCKSDB", "Conflicts", sums[kConflicts]);
+  exporter->write("TRANSACTION-ROCKSDB", "Retries", sums[kRetries]);
+  exporter->write("TRANSACTION-ROCKSDB", "Aborts", sums[kAborts]);
+  if (sums[kAttempts] > 0)
+    exporter->write("TRANSACTION-ROCKSDB", "AbortRate",
+                    (double)sums[kConflicts] / sums[kAttempts]);
+  if (sums[kCommits] > 0)
+    exporter->write("TRANSACTION-ROCKSDB", "RetriesPerCommit",
+                    (double)sums[kRetries] / sums[kCommits]);
+}
+
+} // namespace ycsbc
@@ -0,0 +1,108 @@
+//
+//  rocksdb_txn_db.h
+//  YCSB-C
+//
+
+#ifndef YCSB_C_ROCKSDB_TXN_DB_H_
+#define YCSB_C_ROCKSDB_TXN_DB_H_
+
+#include "db/rocksdb_db.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "core/measurements.h"
+#include "db/rocksdb_options.h"
+#include "rocksdb-cloud/include/rocksdb/utilities/optimistic_transaction_db.h"
+#include "rocksdb-cloud/include/rocksdb/utilities/transaction_db.h"
+
+namespace ycsbc {
+
+///
+/// A RocksdbDB whose Transaction() runs as a rocksdb::Transaction, either
+/// of a TransactionDB, which locks each key as it is read and makes other
+/// transactions wait for it (pessimistic, the rocksdb-txn binding), or of an
+/// OptimisticTransactionDB, which tracks the keys read and fails the commit
+/// if any was written since (optimistic, the rocksdb-occ binding).
+/// Transactions that abort on a conflict are rolled back and retried up to
+/// rocksdb.txn.max_retries times.
+///
+/// Commit() latencies are measured as TRANSACTION-COMMIT, and the outcome of
+/// the transactions is reported with the statistics (see ExportStats()).
+///
+class RocksdbTxnDB : public RocksdbDB {
+ public:
+  enum Concurrency {
+    kPessimistic,
+    kOptimistic
+  };
+
+  RocksdbTxnDB(const RocksdbOptions &options, Concurrency concurrency);
+
+  int Transaction(const std::string &table, const std::vector<std::string> &keys,
+                  std::vector<std::vector<KVPair>> &values);
+
+  ///
+  /// Writes, besides the statistics of RocksdbDB, the TRANSACTION-ROCKSDB
+  /// counts: Attempts, Commits, Conflicts (attempts aborted on a conflict),
+  /// Retries, Aborts (transactions given up after the last retry), AbortRate
+  /// (Conflicts per attempt) and RetriesPerCommit.
+  ///
+  void ExportStats(MeasurementsExporter *exporter);
+
+  void ResetStats();
+
+ private:
+  // What Open() returns to the base class constructor.
+  struct OpenDB {
+    rocksdb::DB *db;
+    rocksdb::TransactionDB *txn_db;
+    rocksdb::OptimisticTransactionDB *occ_db;
+    std::vector<rocksdb::ColumnFamilyHandle*> handles;
+  };
+
+  enum Counter {
+    kCommits,
+    kConflicts,
+    kRetries,
+    kAborts,
+    // Every attempt, including those that end in an error other than a
+    // conflict.
+    kAttempts,
+    kNumCounters
+  };
+
+  struct Shard {
+    std::atomic<uint64_t> counters[kNumCounters];
+    Shard() {
+      for (int i = 0; i < kNumCounters; i++)
+        counters[i].store(0, std::memory_order_relaxed);
+    }
+  };
+
+  static OpenDB Open(const RocksdbOptions &options, Concurrency concurrency);
+  RocksdbTxnDB(const RocksdbOptions &options, const OpenDB &db);
+
+  // Begins a transaction, reusing the handle of txn if it is not NULL.
+  rocksdb::Transaction *Begin(rocksdb::Transaction *txn);
+  // Sums the counters of the shards, less those at the last ResetStats().
+  void SumCounters(uint64_t sums[kNumCounters]);
+  // Runs the transaction once; kErrorConflict if it has to be retried.
+  int Attempt(rocksdb::Transaction *txn, rocksdb::ColumnFamilyHandle *cfh,
+              const std::vector<std::string> &keys,
+              std::vector<std::vector<KVPair>> &values);
+
+  rocksdb::TransactionDB *txn_db_;          // NULL if optimistic
+  rocksdb::OptimisticTransactionDB *occ_db_; // NULL if pessimistic
+  rocksdb::TransactionOptions txn_options_;
+  int max_retries_;
+  ThreadShards<Shard> shards_;
+  std::mutex reset_mutex_;
+  uint64_t counter_base_[kNumCounters] = {};
+};
+
+} // ycsbc
+
+#endif // YCSB_C_ROCKSDB_TXN_DB_H_
@@ -1,4 +1,7 @@
+#include <cassert>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include "core/measurements.h"
 #include "core/properties.h"
@@ -72,9 +75,69 @@ void test_Measurements() {
   std::cout << exporter.buf() << std::endl;
 }
 
+// Records from several threads at once; every thread writes its own shard
+// and the merged export must see all of them.
+void test_ConcurrentRecording() {
+  utils::Properties p;
+  OneMeasurementHdrHistogram hdr("test_ConcurrentHdrHistogram", p);
+  OneMeasurementHistogram histogram("test_ConcurrentHistogram", p);
+  const int num_threads = 8;
+  const int num_ops = 10000;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&hdr, &histogram, t]() {
+      for (int i = 0; i < num_ops; i++) {
+        hdr.measure(i % 100 + t);
+        hdr.report_status(i % 2);
+        histogram.measure(i % 100 + t);
+      }
+    });
+  }
+  for (auto& t : threads)
+    t.join();
+
+  TextMeasurementsExporter exporter;
+  hdr.export_measurements(&exporter);
+  histogram.export_measurements(&exporter);
+  std::cout << "Concurrent recording" << std::endl;
+  std::cout << exporter.buf() << std::endl;
+
+  std::string total = std::to_string(num_threads * num_ops);
+  std::string half = std::to_string(num_threads * num_ops / 2);
+  assert(exporter.buf().find("[test_ConcurrentHdrHistogram], Operations, " + total) != std::string::npos);
+  assert(exporter.buf().find("[test_ConcurrentHdrHistogram], Return=0, " + half) != std::string::npos);
+  assert(exporter.buf().find("[test_ConcurrentHdrHistogram], MaxLatency(us), " + std::to_string(99 + num_threads - 1)) != std::string::npos);
+  assert(exporter.buf().find("[test_ConcurrentHistogram], Operations, " + total) != std::string::npos);
+}
+
+// Latencies recorded before reset(), as during a warm-up, are not exported.
+void test_MeasurementsReset() {
+  Measurements& m = Measurements::get_measurements();
+  for (int i = 0; i < 100; i++) {
+    m.measure(OP_READ, false, 5000);
+    m.measure("alec", 5000);
+  }
+  m.reset();
+  for (int i = 0; i < 10; i++) {
+    m.measure(OP_READ, false, 1);
+    m.measure("alec", 1);
+  }
+
+  TextMeasurementsExporter exporter;
+  m.export_measurements(&exporter);
+  std::cout << "Measurements after reset" << std::endl;
+  std::cout << exporter.buf() << std::endl;
+  assert(exporter.buf().find("[READ], Operations, 10\n") != std::string::npos);
+  assert(exporter.buf().find("[READ], MaxLatency(us), 1\n") != std::string::npos);
+  assert(exporter.buf().find("[alec], Operations, 10\n") != std::string::npos);
+}
+
 int main() {
   test_OneMeasurementRaw();
   test_OneMeasurementHistogram();
   test_OneMeasurementHdrHistogram();
   test_Measurements();
+  test_ConcurrentRecording();
+  test_MeasurementsReset();
 }
\ No newline at end of file
@@ -6,17 +6,21 @@
 //  Copyright (c) 2014 Jinglei Ren <jinglei@ren.systems>.
 //
 
+#include <atomic>
 #include <cstring>
 #include <string>
 #include <iostream>
 #include <vector>
 #include <future>
+#include <memory>
+#include <thread>
 #include "core/utils.h"
 #include "core/timer.h"
 #include "core/client.h"
 #include "core/core_workload.h"
 #include "core/db_wrapper.h"
 #include "core/measurements.h"
+#include "core/status_thread.h"
 #include "db/db_factory.h"
 
 using namespace std;
@@ -24,20 +28,62 @@ using namespace std;
 void UsageMessage(const char *command);
 bool StrStartWith(const char *str, const char *pre);
 string ParseCommandLine(int argc, const char *argv[], utils::Properties &props);
-void export_measurements(ycsbc::MeasurementsExporter* exporter, int total_ops, double duration);
+void export_measurements(ycsbc::MeasurementsExporter* exporter, ycsbc::DB *db, int total_ops, double duration);
+
+uint64_t CompletedOps(const vector<ycsbc::ClientProgress> &progress) {
+  uint64_t ops = 0;
+  for (const ycsbc::ClientProgress &p : progress)
+    ops += p.ops_done.load(std::memory_order_relaxed);
+  return ops;
+}
 
 int DelegateClient(ycsbc::DB *db, ycsbc::CoreWorkload *wl, const int num_ops,
-    bool is_loading) {
+    bool is_loading, const int thread_id, const int num_threads,
+    const double target_ops_per_sec, ycsbc::ClientProgress *progress,
+    const atomic<bool> *measuring, const atomic<bool> *stop, const uint64_t seed) {
   db->Init();
-  ycsbc::Client client(*db, *wl);
+  utils::SeedThreadRandom(seed, thread_id);
+  unique_ptr<ycsbc::CoreWorkload> thread_wl(wl->NewThreadWorkload());
+  // Each client writes a file of its own range of keys.
+  if (is_loading && thread_wl->ingest_load())
+    thread_wl->SetSequenceKeyOffset((uint64_t)thread_id * num_ops);
+  ycsbc::Client client(*db, *thread_wl);
+
+  // Open-loop pacing: with a target, operation i of this thread is scheduled
+  // at start + i * tick and its intended latency is measured from that
+  // point, so time spent queued behind a slow operation is not omitted.
+  uint64_t tick_ns = 0;
+  if (target_ops_per_sec > 0)
+    tick_ns = (uint64_t)(1e9 * num_threads / target_ops_per_sec);
+  // Spread the threads over one tick so they don't all fire together.
+  uint64_t start_ns = utils::NowNanos() + tick_ns * thread_id / num_threads;
+
+  // Operations started during the warm-up are not counted in num_ops.
   int oks = 0;
-  for (int i = 0; i < num_ops; ++i) {
+  int measured_ops = 0;
+  for (uint64_t i = 0; measured_ops < num_ops; ++i) {
+    if (stop->load(std::memory_order_relaxed))
+      break;
+    bool measured = measuring->load(std::memory_order_relaxed);
+    measured_ops += measured;
+    if (tick_ns > 0) {
+      uint64_t deadline = start_ns + i * tick_ns;
+      std::this_thread::sleep_until(std::chrono::system_clock::time_point(
+          std::chrono::duration_cast<std::chrono::system_clock::duration>(
+              std::chrono::nanoseconds(deadline))));
+      ycsbc::Measurements::get_measurements().set_intended_start_time_ns(deadline);
+    }
     if (is_loading) {
       oks += client.DoInsert();
     } else {
       oks += client.DoTransaction();
     }
+    ycsbc::add_relaxed(progress->ops_done, (uint64_t)1);
+    if (!measured)
+      ycsbc::add_relaxed(progress->warmup_ops, (uint64_t)1);
   }
+  oks -= client.Flush();
+  ycsbc::Measurements::get_measurements().set_intended_start_time_ns(0);
   db->Close();
   return oks;
 }
@@ -52,67 +98,148 @@ int main(const int argc, const char *argv[]) {
     exit(0);
   }
 
+  const int num_threads = stoi(props.GetProperty("threadcount", "1"));
+  // Every client thread, this one and the status thread record into shards
+  // of their own, of which there are kMaxMeasurementThreads.
+  if (num_threads < 1 || num_threads > ycsbc::kMaxMeasurementThreads - 2) {
+    cout << "threadcount must be between 1 and "
+         << ycsbc::kMaxMeasurementThreads - 2 << endl;
+    exit(0);
+  }
+  const uint64_t seed = stoull(props.GetProperty(
+      ycsbc::CoreWorkload::SEED_PROPERTY, ycsbc::CoreWorkload::SEED_DEFAULT));
+
+  // The generators are built here; give this thread a stream of its own.
+  utils::SeedThreadRandom(seed, num_threads);
   ycsbc::CoreWorkload wl;
   wl.Init(props);
 
-  const int num_threads = stoi(props.GetProperty("threadcount", "1"));
+  const double target = stod(props.GetProperty("target", "0"));
+  const double max_execution_time = stod(props.GetProperty("maxexecutiontime", "0"));
+  const bool is_loading = props.GetProperty("command", "NULL") == "load";
+  const bool ingest = is_loading && wl.ingest_load();
+  if (ingest && !db->GetIngestDB()) {
+    cout << "load.method=ingest is not supported by " << props["dbname"] << endl;
+    exit(0);
+  }
+
+  // Warm-up operations run before the measured ones and are left out of the
+  // results; it ends once both warmup.ops operations have completed and
+  // warmup.time seconds have passed. Then operationcount operations follow
+  // and maxexecutiontime starts. Loading always inserts exactly recordcount
+  // records, so warm-up only applies to run.
+  uint64_t warmup_ops = 0;
+  double warmup_time = 0;
+  if (!is_loading) {
+    warmup_ops = stoull(props.GetProperty("warmup.ops", "0"));
+    warmup_time = stod(props.GetProperty("warmup.time", "0"));
+  }
+  bool warming_up = warmup_ops > 0 || warmup_time > 0;
+
+  int total_ops;
+  if (is_loading)
+    total_ops = stoi(props[ycsbc::CoreWorkload::RECORD_COUNT_PROPERTY]);
+  else
+    total_ops = stoi(props[ycsbc::CoreWorkload::OPERATION_COUNT_PROPERTY]);
+
+  vector<ycsbc::ClientProgress> progress(num_threads);
+  ycsbc::StatusThread status(props, progress, db);
+  atomic<bool> measuring(!warming_up);
+  atomic<bool> stop(false);
 
   utils::Timer<double> timer;
   timer.Start();
+  status.Start();
+  uint64_t start_ns = utils::NowNanos();
+  uint64_t warmup_end_ns = start_ns + (uint64_t)(warmup_time * 1e9);
+  uint64_t max_execution_ns = (uint64_t)(max_execution_time * 1e9);
+  uint64_t deadline_ns = 0;
+  if (max_execution_ns > 0 && !warming_up)
+    deadline_ns = start_ns + max_execution_ns;
 
-  if (props.GetProperty("command", "NULL") == "load") {
-    // Loads data
-    vector<future<int>> actual_ops;
-    int total_ops = stoi(props[ycsbc::CoreWorkload::RECORD_COUNT_PROPERTY]);
-    for (int i = 0; i < num_threads; ++i) {
-      actual_ops.emplace_back(async(launch::async,
-          DelegateClient, db, &wl, total_ops / num_threads, true));
-    }
-    assert((int)actual_ops.size() == num_threads);
-
-    int sum = 0;
-    for (auto &n : actual_ops) {
-      assert(n.valid());
-      sum += n.get();
-    }
-    cerr << "# Loading records:\t" << sum << endl;
-    double duration = timer.End();
-    ycsbc::TextMeasurementsExporter exporter;
-    export_measurements(&exporter, total_ops, duration);
+  vector<future<int>> actual_ops;
+  for (int i = 0; i < num_threads; ++i) {
+    actual_ops.emplace_back(async(launch::async,
+        DelegateClient, db, &wl, total_ops / num_threads, is_loading, i,
+        num_threads, target, &progress[i], &measuring, &stop, seed));
   }
+  assert((int)actual_ops.size() == num_threads);
 
-  if (props.GetProperty("command", "NULL") == "run") {
-    // Peforms transactions
-    vector<future<int>> actual_ops;
-    int total_ops = stoi(props[ycsbc::CoreWorkload::OPERATION_COUNT_PROPERTY]);
-    for (int i = 0; i < num_threads; ++i) {
-      actual_ops.emplace_back(async(launch::async,
-          DelegateClient, db, &wl, total_ops / num_threads, false));
+  int sum = 0;
+  for (auto &n : actual_ops) {
+    assert(n.valid());
+    while ((warming_up || deadline_ns > 0) &&
+        n.wait_for(chrono::milliseconds(1)) != future_status::ready) {
+      uint64_t now_ns = utils::NowNanos();
+      if (warming_up && now_ns >= warmup_end_ns &&
+          CompletedOps(progress) >= warmup_ops) {
+        ycsbc::Measurements::get_measurements().reset();
+        db->ResetStats();
+        timer.Start();
+        measuring.store(true, std::memory_order_relaxed);
+        warming_up = false;
+        if (max_execution_ns > 0)
+          deadline_ns = now_ns + max_execution_ns;
+      }
+      if (deadline_ns > 0 && now_ns >= deadline_ns) {
+        stop.store(true, std::memory_order_relaxed);
+        deadline_ns = 0;
+      }
     }
-    assert((int)actual_ops.size() == num_threads);
-
-    int sum = 0;
-    for (auto &n : actual_ops) {
-      assert(n.valid());
-      sum += n.get();
+    sum += n.get();
+  }
+  if (ingest) {
+    uint64_t st = utils::NowNanos();
+    int res = db->GetIngestDB()->IngestFiles(wl.NextTable());
+    uint64_t en = utils::NowNanos();
+    ycsbc::Measurements::get_measurements().measure("INGEST", (en - st) / 1000);
+    ycsbc::Measurements::get_measurements().report_status("INGEST", res);
+    cerr << "# Ingesting files (sec):\t" << (en - st) / 1e9 << endl;
+  }
+  status.Stop();
+  double duration = timer.End();
+  // A checkpoint of the loaded records lets runs start from them without
+  // loading again (see checkpoint.restore of the binding). It is not part
+  // of the duration of the load.
+  string checkpoint = props.GetProperty("checkpoint.save", "");
+  if (is_loading && !checkpoint.empty()) {
+    uint64_t st = utils::NowNanos();
+    int res = db->SaveCheckpoint(checkpoint);
+    uint64_t en = utils::NowNanos();
+    if (res == ycsbc::DB::kNotImplemented) {
+      cout << "checkpoint.save is not supported by " << props["dbname"] << endl;
+    } else {
+      ycsbc::Measurements::get_measurements().measure("CHECKPOINT", (en - st) / 1000);
+      ycsbc::Measurements::get_measurements().report_status("CHECKPOINT", res);
+      cerr << "# Saving checkpoint (sec):\t" << (en - st) / 1e9 << endl;
     }
-    cerr << "# Transaction numbers:\t" << sum << endl;
-    double duration = timer.End();
-    ycsbc::TextMeasurementsExporter exporter;
-    export_measurements(&exporter, total_ops, duration);
   }
+  // The operations of the warm-up are left out, as in the throughput.
+  uint64_t unmeasured_ops = 0;
+  for (const ycsbc::ClientProgress &p : progress)
+    unmeasured_ops += p.warmup_ops.load(std::memory_order_relaxed);
+  if (unmeasured_ops > 0)
+    cerr << "# Warm-up operations:\t" << unmeasured_ops << endl;
+  uint64_t measured_ops = CompletedOps(progress) - unmeasured_ops;
+  if (is_loading)
+    cerr << "# Loading records:\t" << sum << endl;
+  else
+    cerr << "# Transaction numbers:\t" << measured_ops << endl;
+  ycsbc::TextMeasurementsExporter exporter;
+  export_measurements(&exporter, db, measured_ops, duration);
   // cerr << "# Transaction throughput (KTPS)" << endl;
   // cerr << props["dbname"] << '\t' << file_name << '\t' << num_threads << '\t';
   // cerr << total_ops / duration / 1000 << endl;
   delete db;
 }
 
-void export_measurements(ycsbc::MeasurementsExporter* exporter, int total_ops, double duration) {
+void export_measurements(ycsbc::MeasurementsExporter* exporter, ycsbc::DB *db, int total_ops, double duration) {
   exporter->write("OVERALL", "RunTime(ms)", 1000 * duration);
   exporter->write("OVERALL", "Throughput(ops/sec)", total_ops / duration);
 
   cout << ycsbc::Measurements::get_measurements().get_summary() << endl;
   ycsbc::Measurements::get_measurements().export_measurements(exporter);
+  db->ExportStats(exporter);
   exporter->print();
 }
 
@@ -174,6 +301,14 @@ string ParseCommandLine(int argc, const char *argv[], utils::Properties &props)
       }
       props.SetProperty("slaves", argv[argindex]);
       argindex++;
+    } else if (strcmp(argv[argindex], "-target") == 0) {
+      argindex++;
+      if (argindex >= argc) {
+        UsageMessage(argv[0]);
+        exit(0);
+      }
+      props.SetProperty("target", argv[argindex]);
+      argindex++;
     } else if (strcmp(argv[argindex], "-P") == 0) {
       argindex++;
       if (argindex >= argc) {
@@ -212,6 +347,9 @@ void UsageMessage(const char *command) {
   cout << "Options:" << endl;
   cout << "  -threads n: execute using n threads (default: 1)" << endl;
   cout << "  -db dbname: specify the name of the DB to use (default: basic)" << endl;
+  cout << "  -target n: attempt to do n operations per second in total (default:" << endl;
+  cout << "             unthrottled); latencies are then also measured from each" << endl;
+  cout << "             operation's intended start time" << endl;
   cout << "  -P propertyfile: load properties from the given file. Multiple files can" << endl;
   cout << "                   be specified, and will be processed in the order specified" << endl;
 }